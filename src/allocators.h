@@ -0,0 +1,398 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// malloc-backed allocator. For trivially relocatable elements Vector's
+// Reserve and appends grow the buffer through reallocate(), i.e. std::realloc,
+// which can extend the block without copying; when it can't, realloc does the
+// copy itself.
+template <typename T>
+class MallocAllocator {
+public:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc can't satisfy over-aligned types");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    MallocAllocator() = default;
+
+    template <typename U>
+    MallocAllocator(const MallocAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        void* ptr = std::malloc(n * sizeof(T));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        std::free(ptr);
+    }
+
+    T* reallocate(T* ptr, size_t, size_t new_n) {
+        void* new_ptr = std::realloc(ptr, new_n * sizeof(T));
+        if (new_ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(new_ptr);
+    }
+
+    template <typename U>
+    bool operator==(const MallocAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const MallocAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+// Bump-pointer memory resource for objects that all die together, e.g. the
+// vectors built while handling one request. Deallocation is a no-op and Reset()
+// rewinds to the first block in O(1), keeping every block for reuse, so a
+// warmed-up arena serves later rounds without touching the global heap.
+class MonotonicArena {
+public:
+    explicit MonotonicArena(size_t block_size = 64 * 1024)
+        : next_block_size_(block_size) {
+    }
+
+    // Starts from a caller-owned buffer, which the arena never frees.
+    MonotonicArena(void* buffer, size_t size, size_t block_size = 64 * 1024)
+        : next_block_size_(block_size) {
+        void* aligned = buffer;
+        if (std::align(alignof(Block), sizeof(Block), aligned, size) != nullptr) {
+            head_ = current_ = new (aligned) Block{nullptr, size - sizeof(Block), false};
+        }
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() {
+        for (Block* block = head_; block != nullptr;) {
+            Block* next = block->next;
+            if (block->owned) {
+                ::operator delete(block);
+            }
+            block = next;
+        }
+    }
+
+    void* Allocate(size_t bytes, size_t alignment) {
+        while (true) {
+            if (current_ != nullptr) {
+                if (void* ptr = TryBump(bytes, alignment)) {
+                    return ptr;
+                }
+                if (current_->next != nullptr) {
+                    current_ = current_->next;
+                    offset_ = 0;
+                    continue;
+                }
+            }
+            AddBlock(bytes + alignment);
+        }
+    }
+
+    // Extends or shrinks the most recent allocation in place when it's still on
+    // top of the current block; otherwise moves the bytes to a new allocation.
+    void* Reallocate(void* ptr, size_t old_bytes, size_t new_bytes, size_t alignment) {
+        if (current_ != nullptr) {
+            unsigned char* top = current_->Data() + offset_;
+            unsigned char* start = static_cast<unsigned char*>(ptr);
+            if (start + old_bytes == top && start + new_bytes <= current_->Data() + current_->size) {
+                offset_ = (start - current_->Data()) + new_bytes;
+                return ptr;
+            }
+        }
+        void* new_ptr = Allocate(new_bytes, alignment);
+        std::memcpy(new_ptr, ptr, std::min(old_bytes, new_bytes));
+        return new_ptr;
+    }
+
+    void Reset() noexcept {
+        current_ = head_;
+        offset_ = 0;
+    }
+
+private:
+    struct alignas(std::max_align_t) Block {
+        Block* next;
+        size_t size;
+        bool owned;
+
+        unsigned char* Data() noexcept {
+            return reinterpret_cast<unsigned char*>(this + 1);
+        }
+    };
+
+    void* TryBump(size_t bytes, size_t alignment) noexcept {
+        uintptr_t base = reinterpret_cast<uintptr_t>(current_->Data());
+        uintptr_t aligned = (base + offset_ + alignment - 1) & ~(uintptr_t{alignment} - 1);
+        if (aligned + bytes > base + current_->size) {
+            return nullptr;
+        }
+        offset_ = aligned + bytes - base;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Appends a block after the last one; only called once current_ is the tail.
+    void AddBlock(size_t min_size) {
+        size_t size = std::max(min_size, next_block_size_);
+        Block* block = new (::operator new(sizeof(Block) + size)) Block{nullptr, size, true};
+        if (current_ == nullptr) {
+            head_ = block;
+        }
+        else {
+            current_->next = block;
+        }
+        current_ = block;
+        offset_ = 0;
+        next_block_size_ *= 2;
+    }
+
+    Block* head_ = nullptr;
+    Block* current_ = nullptr;
+    size_t offset_ = 0;
+    size_t next_block_size_;
+};
+
+// Standard allocator drawing from a MonotonicArena. Like std::pmr allocators
+// it never propagates, so containers stay bound to the arena they were built in.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena& arena) noexcept
+        : arena_(&arena) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : arena_(other.GetArena()) {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {
+    }
+
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        return static_cast<T*>(arena_->Reallocate(ptr, old_n * sizeof(T), new_n * sizeof(T), alignof(T)));
+    }
+
+    MonotonicArena* GetArena() const noexcept {
+        return arena_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.GetArena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ != other.GetArena();
+    }
+
+private:
+    MonotonicArena* arena_;
+};
+
+// Recycles buffers by power-of-two size class. Vector grows geometrically, so
+// its buffers cluster into a few classes and a freed buffer is usually what the
+// next growing vector asks for. Every thread keeps its own free lists, so the
+// fast path takes no locks; a buffer freed on another thread simply joins that
+// thread's cache. Requests above the largest class go straight to operator new.
+class SizeClassPool {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    static void* Allocate(size_t bytes) {
+        size_t index = ClassIndex(bytes);
+        if (index >= kClassCount || cache_destroyed_) {
+            return ::operator new(bytes);
+        }
+
+        ThreadCache& cache = Cache();
+        if (FreeBlock* block = cache.heads[index]) {
+            cache.heads[index] = block->next;
+            --cache.counts[index];
+            ++cache.stats.hits;
+            return block;
+        }
+        ++cache.stats.misses;
+        return ::operator new(ClassSize(index));
+    }
+
+    static void Deallocate(void* ptr, size_t bytes) noexcept {
+        size_t index = ClassIndex(bytes);
+        if (index >= kClassCount || cache_destroyed_) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        ThreadCache& cache = Cache();
+        if (cache.counts[index] >= MaxCachedBlocks(index)) {
+            ::operator delete(ptr);
+            return;
+        }
+        cache.heads[index] = new (ptr) FreeBlock{cache.heads[index]};
+        ++cache.counts[index];
+    }
+
+    // Counters of the calling thread.
+    static Stats ThreadStats() noexcept {
+        return cache_destroyed_ ? Stats{} : Cache().stats;
+    }
+
+private:
+    static constexpr size_t kMinClassShift = 4;
+    static constexpr size_t kClassCount = 23;  // 16 bytes .. 64 MiB
+    static constexpr size_t kCachedBytesPerClass = size_t{4} << 20;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct ThreadCache {
+        ~ThreadCache() {
+            cache_destroyed_ = true;
+            for (FreeBlock* head : heads) {
+                while (head != nullptr) {
+                    FreeBlock* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+
+        FreeBlock* heads[kClassCount] = {};
+        size_t counts[kClassCount] = {};
+        Stats stats;
+    };
+
+    static ThreadCache& Cache() noexcept {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static size_t ClassIndex(size_t bytes) noexcept {
+        size_t index = 0;
+        while ((ClassSize(index)) < bytes) {
+            ++index;
+        }
+        return index;
+    }
+
+    static constexpr size_t ClassSize(size_t index) noexcept {
+        return size_t{1} << (index + kMinClassShift);
+    }
+
+    // Caps the memory a thread parks in one class, but always keeps one block.
+    static constexpr size_t MaxCachedBlocks(size_t index) noexcept {
+        return std::max<size_t>(1, kCachedBytesPerClass / ClassSize(index));
+    }
+
+    // Buffers released during thread exit, after the cache is gone, bypass it.
+    static inline thread_local bool cache_destroyed_ = false;
+};
+
+template <typename T>
+class PoolAllocator {
+public:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "pool blocks use the default new alignment");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(SizeClassPool::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        SizeClassPool::Deallocate(ptr, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+// Allocator returning buffers aligned to Alignment bytes (a cache line by
+// default; 4096 for page alignment) with the byte size rounded up to a multiple
+// of Alignment, so SIMD kernels can use aligned full-width loads all the way
+// through the last element. The padding past Capacity() is never constructed.
+template <typename T, size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    static_assert((Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "alignment must not be weaker than T's own");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(PaddedSize(n), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        ::operator delete(ptr, PaddedSize(n), std::align_val_t{Alignment});
+    }
+
+    static constexpr size_t PaddedSize(size_t n) noexcept {
+        return (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
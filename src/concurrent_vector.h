@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "vector.h"
+
+// Append-only vector that many threads can push to at once, without a mutex.
+// A push claims its index with one fetch_add and constructs the element in
+// place; segment k holds BaseSize * 2^k elements and, once allocated, stays
+// put, so growth never copies anything and references stay valid.
+//
+// Pushes are not lock-free. The thread that claims a segment's first index
+// allocates and installs it, and a thread claiming a later index of a segment
+// not yet installed yields until it appears, for up to kSegmentWaitYields
+// rounds. Only then does it allocate the segment itself and race to install
+// it with a CAS, freeing its copy if it loses, so a preempted claimer delays
+// the others but can't block them for good.
+//
+// An element may be read once it is published, i.e. its constructor has
+// finished: by the pushing thread itself, by a thread that learned the index
+// through other synchronization, or after IsPublished(index) returned true.
+// Destruction must not race with pushes.
+template <typename T, size_t BaseSize = 64>
+class ConcurrentVector {
+    static_assert(BaseSize > 0 && (BaseSize & (BaseSize - 1)) == 0, "base size must be a power of two");
+
+    struct Segment {
+        explicit Segment(size_t capacity)
+            : elements(capacity)
+            , published(new std::atomic<bool>[capacity]()) {
+        }
+
+        RawMemory<T> elements;
+        std::unique_ptr<std::atomic<bool>[]> published;
+    };
+
+    static constexpr size_t kMaxSegments = 48;
+    static constexpr size_t kSegmentWaitYields = 1 << 16;
+
+public:
+    ConcurrentVector() = default;
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        size_t size = reserved_.load(std::memory_order_acquire);
+        for (size_t index = 0; index < size; ++index) {
+            if (IsPublished(index)) {
+                std::destroy_at(Slot(index));
+            }
+        }
+        for (auto& segment : segments_) {
+            delete segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Each push returns the index it claimed.
+    size_t PushBack(const T& value) {
+        return EmplaceBack(value);
+    }
+
+    size_t PushBack(T&& value) {
+        return EmplaceBack(std::move(value));
+    }
+
+    // If the constructor throws, the claimed index stays unpublished for good.
+    template <typename... Args>
+    size_t EmplaceBack(Args&&... args) {
+        size_t index = reserved_.fetch_add(1, std::memory_order_relaxed);
+        auto [segment_index, offset] = Locate(index);
+
+        Segment* segment = GetOrCreateSegment(segment_index, offset);
+        new (segment->elements + offset) T(std::forward<Args>(args)...);
+        segment->published[offset].store(true, std::memory_order_release);
+        return index;
+    }
+
+    bool IsPublished(size_t index) const noexcept {
+        if (index >= reserved_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        auto [segment_index, offset] = Locate(index);
+        const Segment* segment = segments_[segment_index].load(std::memory_order_acquire);
+        return segment != nullptr && segment->published[offset].load(std::memory_order_acquire);
+    }
+
+    // Calls f(index, element) for every element published so far.
+    template <typename F>
+    void ForEachPublished(F f) const {
+        size_t size = reserved_.load(std::memory_order_acquire);
+        for (size_t index = 0; index < size; ++index) {
+            if (IsPublished(index)) {
+                f(index, (*this)[index]);
+            }
+        }
+    }
+
+    // Number of claimed indices; the newest ones may still be under construction.
+    size_t Size() const noexcept {
+        return reserved_.load(std::memory_order_acquire);
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(IsPublished(index));
+        return *Slot(index);
+    }
+
+private:
+    struct Location {
+        size_t segment;
+        size_t offset;
+    };
+
+    // Segment k starts at BaseSize * (2^k - 1).
+    static Location Locate(size_t index) noexcept {
+        size_t block = index / BaseSize + 1;
+        size_t segment = Log2(block);
+        return {segment, index - BaseSize * ((size_t{1} << segment) - 1)};
+    }
+
+    static size_t Log2(size_t value) noexcept {
+#if defined(__GNUC__)
+        return static_cast<size_t>(63 - __builtin_clzll(value));
+#else
+        size_t result = 0;
+        while (value >>= 1) {
+            ++result;
+        }
+        return result;
+#endif
+    }
+
+    static size_t SegmentCapacity(size_t segment) noexcept {
+        return BaseSize << segment;
+    }
+
+    T* Slot(size_t index) noexcept {
+        auto [segment_index, offset] = Locate(index);
+        return segments_[segment_index].load(std::memory_order_acquire)->elements + offset;
+    }
+
+    // Called with the offset of the index just claimed in the segment. Only
+    // the claimer of offset 0 allocates right away; the rest wait for it, up to
+    // kSegmentWaitYields yields, before racing to install their own copy.
+    Segment* GetOrCreateSegment(size_t segment_index, size_t offset) {
+        assert(segment_index < kMaxSegments);
+        std::atomic<Segment*>& slot = segments_[segment_index];
+
+        Segment* segment = slot.load(std::memory_order_acquire);
+        if (offset != 0) {
+            for (size_t i = 0; segment == nullptr && i < kSegmentWaitYields; ++i) {
+                std::this_thread::yield();
+                segment = slot.load(std::memory_order_acquire);
+            }
+        }
+        if (segment != nullptr) {
+            return segment;
+        }
+
+        auto created = std::make_unique<Segment>(SegmentCapacity(segment_index));
+        if (slot.compare_exchange_strong(segment, created.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return created.release();
+        }
+        return segment;
+    }
+
+    std::atomic<size_t> reserved_{0};
+    std::atomic<Segment*> segments_[kMaxSegments] = {};
+};
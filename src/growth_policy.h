@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+// A growth policy decides the capacity Vector reallocates to once it is full:
+// static size_t NextCapacity(size_t capacity, size_t elem_size) must return
+// a value greater than capacity.
+//
+// A policy may also define static size_t ShrinkCapacity(size_t size,
+// size_t capacity, size_t elem_size); Vector then reallocates to the returned
+// capacity after removals whenever it is smaller than the current one.
+
+inline constexpr size_t kCacheLineSize = 64;
+
+// Enough elements to fill one cache line, but never less than one.
+constexpr size_t MinInitialCapacity(size_t elem_size) noexcept {
+    return std::max<size_t>(1, kCacheLineSize / elem_size);
+}
+
+// Multiplies the capacity by Num / Den.
+template <size_t Num, size_t Den>
+struct GeometricGrowth {
+    static_assert(Num > Den, "growth factor must be greater than 1");
+
+    static size_t NextCapacity(size_t capacity, size_t elem_size) noexcept {
+        if (capacity == 0) {
+            return MinInitialCapacity(elem_size);
+        }
+        return std::max(capacity + 1, capacity / Den * Num + capacity % Den * Num / Den);
+    }
+};
+
+using DoublingGrowth = GeometricGrowth<2, 1>;
+using OneAndHalfGrowth = GeometricGrowth<3, 2>;
+using GoldenRatioGrowth = GeometricGrowth<1618, 1000>;
+
+template <size_t Increment>
+struct FixedIncrementGrowth {
+    static_assert(Increment > 0);
+
+    static size_t NextCapacity(size_t capacity, size_t elem_size) noexcept {
+        if (capacity == 0) {
+            return std::max(Increment, MinInitialCapacity(elem_size));
+        }
+        return capacity + Increment;
+    }
+};
+
+// Once a buffer spans at least a page, rounds it up to whole pages so the
+// tail of the last page isn't wasted.
+template <typename Base = DoublingGrowth, size_t PageSize = 4096>
+struct PageRoundedGrowth {
+    static size_t NextCapacity(size_t capacity, size_t elem_size) noexcept {
+        size_t bytes = Base::NextCapacity(capacity, elem_size) * elem_size;
+        if (bytes >= PageSize) {
+            bytes = (bytes + PageSize - 1) / PageSize * PageSize;
+        }
+        return bytes / elem_size;
+    }
+};
+
+// Rounds the byte size up to a jemalloc-style size class (four classes per
+// power of two, 16-byte quantum), so the allocator's slack becomes capacity.
+template <typename Base = OneAndHalfGrowth>
+struct SizeClassGrowth {
+    static size_t RoundUpToSizeClass(size_t bytes) noexcept {
+        constexpr size_t kQuantum = 16;
+        if (bytes <= kQuantum) {
+            return kQuantum;
+        }
+        size_t lg = 0;
+        for (size_t n = bytes - 1; n > 1; n >>= 1) {
+            ++lg;
+        }
+        size_t delta = std::max(kQuantum, size_t{1} << (lg >= 2 ? lg - 2 : 0));
+        return (bytes + delta - 1) / delta * delta;
+    }
+
+    static size_t NextCapacity(size_t capacity, size_t elem_size) noexcept {
+        return RoundUpToSizeClass(Base::NextCapacity(capacity, elem_size) * elem_size) / elem_size;
+    }
+};
+
+template <typename Growth, typename = void>
+struct HasShrinkCapacity : std::false_type {
+};
+
+template <typename Growth>
+struct HasShrinkCapacity<Growth, std::void_t<decltype(Growth::ShrinkCapacity(size_t{}, size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// Grows like Base and shrinks to Slack * size once size drops below
+// capacity / Threshold. The gap between the two factors is the hysteresis:
+// after a shrink the vector has to double or halve again before it reallocates.
+template <typename Base = DoublingGrowth, size_t Threshold = 4, size_t Slack = 2>
+struct HysteresisShrink : Base {
+    static_assert(Threshold > Slack && Slack >= 1);
+
+    static size_t ShrinkCapacity(size_t size, size_t capacity, size_t elem_size) noexcept {
+        size_t min_capacity = MinInitialCapacity(elem_size);
+        if (capacity <= min_capacity || size >= capacity / Threshold) {
+            return capacity;
+        }
+        return std::max(size * Slack, min_capacity);
+    }
+};
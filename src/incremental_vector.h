@@ -0,0 +1,309 @@
+#pragma once
+
+#include "vector.h"
+
+// Vector variant that bounds the worst-case cost of PushBack. When the buffer
+// is full it allocates the bigger one but leaves the elements where they are;
+// every later push then migrates MigrationStep of them, so no single push
+// copies the whole vector. While a migration is in flight both buffers are
+// live and element i is found in the old one iff migrated_ <= i < old_size_.
+//
+// With a geometric Growth policy and MigrationStep >= 1 the old buffer is
+// drained before the new one fills up. The mutable begin()/end() return
+// pointers into a contiguous buffer, so they finish any pending migration
+// first; the const ones return index-based iterators and leave it alone.
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth, size_t MigrationStep = 2>
+class IncrementalVector {
+    static_assert(MigrationStep > 0);
+
+    // Reads through operator[], so a const vector can be walked mid-migration
+    // without finishing it.
+    class ConstIterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        ConstIterator() = default;
+
+        ConstIterator(const IncrementalVector* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        reference operator*() const noexcept {
+            return (*owner_)[index_];
+        }
+        pointer operator->() const noexcept {
+            return &(*owner_)[index_];
+        }
+        reference operator[](difference_type offset) const noexcept {
+            return (*owner_)[index_ + offset];
+        }
+
+        ConstIterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+        ConstIterator operator++(int) noexcept {
+            return ConstIterator(owner_, index_++);
+        }
+        ConstIterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+        ConstIterator operator--(int) noexcept {
+            return ConstIterator(owner_, index_--);
+        }
+        ConstIterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+        ConstIterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+        friend ConstIterator operator+(ConstIterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+        friend ConstIterator operator+(difference_type offset, ConstIterator it) noexcept {
+            return it += offset;
+        }
+        friend ConstIterator operator-(ConstIterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+        friend difference_type operator-(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+        friend bool operator!=(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+        friend bool operator<(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+        friend bool operator>(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return lhs.index_ > rhs.index_;
+        }
+        friend bool operator<=(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return lhs.index_ <= rhs.index_;
+        }
+        friend bool operator>=(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+            return lhs.index_ >= rhs.index_;
+        }
+
+    private:
+        const IncrementalVector* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using iterator = T*;
+    using const_iterator = ConstIterator;
+    using allocator_type = Alloc;
+
+    IncrementalVector() = default;
+
+    explicit IncrementalVector(const Alloc& alloc) noexcept
+        : data_(alloc)
+        , old_(alloc) {
+    }
+
+    IncrementalVector(const IncrementalVector&) = delete;
+    IncrementalVector& operator=(const IncrementalVector&) = delete;
+
+    IncrementalVector(IncrementalVector&& other) noexcept
+        : data_(std::move(other.data_))
+        , old_(std::move(other.old_))
+        , size_(std::exchange(other.size_, 0))
+        , migrated_(std::exchange(other.migrated_, 0))
+        , old_size_(std::exchange(other.old_size_, 0)) {
+    }
+
+    ~IncrementalVector() {
+        DestroyAll();
+    }
+
+    // Finishes any pending migration.
+    iterator begin() {
+        FinishMigration();
+        return data_.GetAddress();
+    }
+    iterator end() {
+        FinishMigration();
+        return data_.GetAddress() + size_;
+    }
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    // Does O(MigrationStep) element moves plus, at most, one allocation.
+    // The new element is built before anything migrates, since args may refer
+    // to an element that is about to move; if a later step throws, it is
+    // destroyed again and nothing was added.
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        T* slot;
+        if (size_ == data_.Capacity()) {
+            RawMemory<T, Alloc> new_data(Growth::NextCapacity(data_.Capacity(), sizeof(T)), data_.GetAllocator());
+            slot = new (new_data + size_) T(std::forward<Args>(args)...);
+            try {
+                FinishMigration();
+            }
+            catch (...) {
+                std::destroy_at(slot);
+                throw;
+            }
+            StartMigration(new_data);
+        }
+        else {
+            slot = new (data_ + size_) T(std::forward<Args>(args)...);
+        }
+
+        try {
+            MigrateSome(MigrationStep);
+        }
+        catch (...) {
+            std::destroy_at(slot);
+            throw;
+        }
+        ++size_;
+        return *slot;
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        std::destroy_at(Slot(size_ - 1));
+        --size_;
+        if (old_size_ > size_) {
+            old_size_ = std::max(migrated_, size_);
+        }
+        if (migrated_ == old_size_) {
+            ReleaseOld();
+        }
+    }
+
+    void Reserve(size_t new_capacity) {
+        FinishMigration();
+        if (new_capacity <= data_.Capacity()) {
+            return;
+        }
+        RawMemory<T, Alloc> new_data(new_capacity, data_.GetAllocator());
+        MoveElements(data_.GetAddress(), size_, new_data.GetAddress());
+        data_.Swap(new_data);
+    }
+
+    // Completes an in-flight migration in one go.
+    void FinishMigration() {
+        MigrateSome(old_size_ - migrated_);
+    }
+
+    bool IsMigrating() const noexcept {
+        return migrated_ < old_size_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<IncrementalVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return *Slot(index);
+    }
+
+private:
+    T* Slot(size_t index) noexcept {
+        return (index >= migrated_ && index < old_size_) ? old_ + index : data_ + index;
+    }
+
+    // Makes new_data the current buffer; no migration may be in flight.
+    void StartMigration(RawMemory<T, Alloc>& new_data) noexcept {
+        old_.Swap(data_);
+        data_.Swap(new_data);
+        migrated_ = 0;
+        old_size_ = size_;
+        if (old_size_ == 0) {
+            ReleaseOld();
+        }
+    }
+
+    void MigrateSome(size_t count) {
+        count = std::min(count, old_size_ - migrated_);
+        if (count == 0) {
+            return;
+        }
+        MoveElements(old_ + migrated_, count, data_ + migrated_);
+        migrated_ += count;
+        if (migrated_ == old_size_) {
+            ReleaseOld();
+        }
+    }
+
+    void ReleaseOld() noexcept {
+        RawMemory<T, Alloc> released(old_.GetAllocator());
+        old_.Swap(released);
+        migrated_ = 0;
+        old_size_ = 0;
+    }
+
+    // Move-constructs count elements at to and destroys the sources; on failure
+    // nothing has changed.
+    void MoveElements(T* from, size_t count, T* to) {
+        if constexpr (IsTriviallyRelocatable<T>::value) {
+            if (count != 0) {
+                std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+            }
+        }
+        else {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+                std::uninitialized_move_n(from, count, to);
+            }
+            else {
+                std::uninitialized_copy_n(from, count, to);
+            }
+            std::destroy_n(from, count);
+        }
+    }
+
+    void DestroyAll() noexcept {
+        for (size_t i = 0; i < size_; ++i) {
+            std::destroy_at(Slot(i));
+        }
+    }
+
+    RawMemory<T, Alloc> data_;
+    RawMemory<T, Alloc> old_;
+    size_t size_ = 0;
+    size_t migrated_ = 0;
+    size_t old_size_ = 0;
+};
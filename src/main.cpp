@@ -1,4 +1,515 @@
+// Benchmarks Vector against std::vector.
+//
+// Build with optimizations and -DNDEBUG, otherwise Vector's bounds asserts
+// are measured too.
+//
+// Usage: main [--json] [--max-size=N] [--filter=SUBSTRING]
+//
+// --filter matches benchmark names without the trailing size. --json prints
+// results in Google Benchmark's JSON layout, so runs from different releases
+// can be diffed with its compare.py tooling.
 
-int main() {
+#include "allocators.h"
+#include "concurrent_vector.h"
+#include "parallel.h"
+#include "vector.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Total number of elements each benchmark touches across its iterations.
+constexpr size_t kWorkPerBenchmark = size_t{1} << 22;
+// Caps iterations for tiny sizes, where clock overhead dominates anyway.
+constexpr size_t kMaxIterations = 10000;
+// Number of Emplace/Erase calls in the middle of a vector per iteration.
+constexpr size_t kMiddleOps = 16;
+// Number of short-lived vectors built by one simulated request.
+constexpr size_t kVectorsPerRequest = 32;
+// Elements appended in total, across all threads, by the concurrent benchmarks.
+constexpr size_t kConcurrentPushes = size_t{1} << 20;
+
+template <typename T>
+void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Element whose move constructor may throw, so Vector has to copy on growth.
+struct ThrowingMove {
+    explicit ThrowingMove(size_t i)
+        : value(std::to_string(i)) {
+    }
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&& other) noexcept(false)
+        : value(std::move(other.value)) {
+    }
+    ThrowingMove& operator=(const ThrowingMove&) = default;
+    ThrowingMove& operator=(ThrowingMove&&) = default;
+
+    std::string value;
+};
+
+// Nothrow-movable element without assignment, which std::vector can't insert
+// in the middle.
+struct NonAssignable {
+    explicit NonAssignable(size_t i)
+        : value(std::make_unique<size_t>(i)) {
+    }
+    NonAssignable(NonAssignable&&) noexcept = default;
+    NonAssignable& operator=(NonAssignable&&) = delete;
+
+    std::unique_ptr<size_t> value;
+};
+
+template <typename E>
+E MakeElement(size_t i) {
+    if constexpr (std::is_same_v<E, std::unique_ptr<int>>) {
+        return std::make_unique<int>(static_cast<int>(i));
+    }
+    else {
+        return E(i);
+    }
+}
+
+// Adapters giving Vector and std::vector one spelling.
+
+template <typename T, typename A, typename G>
+void Append(Vector<T, A, G>& v, T&& value) {
+    v.PushBack(std::move(value));
+}
+template <typename T>
+void Append(std::vector<T>& v, T&& value) {
+    v.push_back(std::move(value));
+}
+
+template <typename T, typename A, typename G>
+void AppendEmplace(Vector<T, A, G>& v, size_t i) {
+    v.EmplaceBack(MakeElement<T>(i));
+}
+template <typename T>
+void AppendEmplace(std::vector<T>& v, size_t i) {
+    v.emplace_back(MakeElement<T>(i));
+}
+
+template <typename T, typename A, typename G>
+void EmplaceMiddle(Vector<T, A, G>& v, size_t i) {
+    v.Emplace(v.begin() + v.Size() / 2, MakeElement<T>(i));
+}
+template <typename T>
+void EmplaceMiddle(std::vector<T>& v, size_t i) {
+    v.emplace(v.begin() + v.size() / 2, MakeElement<T>(i));
+}
+
+template <typename T, typename A, typename G>
+void EraseMiddle(Vector<T, A, G>& v) {
+    v.Erase(v.begin() + v.Size() / 2);
+}
+template <typename T>
+void EraseMiddle(std::vector<T>& v) {
+    v.erase(v.begin() + v.size() / 2);
+}
+
+template <typename T, typename A, typename G>
+void ReserveFor(Vector<T, A, G>& v, size_t n) {
+    v.Reserve(n);
+}
+template <typename T>
+void ReserveFor(std::vector<T>& v, size_t n) {
+    v.reserve(n);
+}
+
+template <typename T, typename A, typename G>
+void ResizeTo(Vector<T, A, G>& v, size_t n) {
+    v.Resize(n);
+}
+template <typename T>
+void ResizeTo(std::vector<T>& v, size_t n) {
+    v.resize(n);
+}
+
+template <typename C>
+C MakeFilled(size_t n) {
+    using E = std::remove_reference_t<decltype(*std::declval<C&>().begin())>;
+    C v;
+    ReserveFor(v, n);
+    for (size_t i = 0; i < n; ++i) {
+        Append(v, MakeElement<E>(i));
+    }
+    return v;
+}
+
+// Extra per-benchmark values, reported next to the timings.
+using Counters = std::vector<std::pair<std::string, double>>;
+
+struct Options {
+    bool json = false;
+    size_t max_size = 100'000'000;
+    const char* filter = "";
+};
+
+class Runner {
+public:
+    explicit Runner(const Options& options)
+        : options_(options) {
+    }
+
+    bool Matches(const std::string& name) const {
+        return std::strstr(name.c_str(), options_.filter) != nullptr;
+    }
+
+    // Times body(state) on a fresh state from setup() in every iteration;
+    // setup and the destruction of the state are not timed.
+    template <typename Setup, typename Body>
+    void Run(const std::string& name, size_t size, size_t work_per_iteration, Setup setup, Body body,
+             const Counters& counters = {}) {
+        if (!Matches(name)) {
+            return;
+        }
+
+        size_t iterations = std::clamp<size_t>(kWorkPerBenchmark / std::max<size_t>(1, work_per_iteration), 1, kMaxIterations);
+        std::chrono::duration<double, std::nano> total{};
+        for (size_t i = 0; i < iterations; ++i) {
+            auto state = setup();
+            auto start = Clock::now();
+            body(state);
+            total += Clock::now() - start;
+            DoNotOptimize(state);
+        }
+
+        Report(name + "/" + std::to_string(size), iterations, total.count() / iterations, counters);
+    }
+
+    void Finish() {
+        if (options_.json) {
+            if (reported_ == 0) {
+                PrintJsonHeader();
+            }
+            std::printf(reported_ == 0 ? "]\n}\n" : "\n  ]\n}\n");
+        }
+    }
+
+private:
+    void PrintJsonHeader() {
+        std::printf("{\n  \"context\": {\n    \"library\": \"SimpleVector\",\n    \"work_per_benchmark\": %zu\n  },\n"
+                    "  \"benchmarks\": [", kWorkPerBenchmark);
+    }
+
+    void Report(const std::string& name, size_t iterations, double ns, const Counters& counters) {
+        if (options_.json) {
+            if (reported_ == 0) {
+                PrintJsonHeader();
+                std::printf("\n");
+            }
+            else {
+                std::printf(",\n");
+            }
+            std::printf("    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %zu, "
+                        "\"real_time\": %.1f, \"cpu_time\": %.1f, \"time_unit\": \"ns\"",
+                        name.c_str(), iterations, ns, ns);
+            // Google Benchmark writes user counters as extra fields.
+            for (const auto& [counter, value] : counters) {
+                std::printf(", \"%s\": %.1f", counter.c_str(), value);
+            }
+            std::printf("}");
+        }
+        else {
+            std::printf("%-52s %14.1f ns %10zu", name.c_str(), ns, iterations);
+            for (const auto& [counter, value] : counters) {
+                std::printf("  %s=%.1f", counter.c_str(), value);
+            }
+            std::printf("\n");
+        }
+        ++reported_;
+    }
+
+    Options options_;
+    size_t reported_ = 0;
+};
+
+template <typename C, typename E>
+void BenchmarkContainer(Runner& runner, const std::string& prefix, size_t n) {
+    auto empty = [] { return C(); };
+    auto filled = [n] { return MakeFilled<C>(n); };
+
+    runner.Run(prefix + "PushBack", n, n, empty, [n](C& v) {
+        for (size_t i = 0; i < n; ++i) {
+            Append(v, MakeElement<E>(i));
+        }
+    });
+    runner.Run(prefix + "EmplaceBack", n, n, empty, [n](C& v) {
+        for (size_t i = 0; i < n; ++i) {
+            AppendEmplace(v, i);
+        }
+    });
+    runner.Run(prefix + "EmplaceMiddle", n, n * kMiddleOps, filled, [](C& v) {
+        for (size_t i = 0; i < kMiddleOps; ++i) {
+            EmplaceMiddle(v, i);
+        }
+    });
+    if (n >= kMiddleOps) {
+        runner.Run(prefix + "EraseMiddle", n, n * kMiddleOps, filled, [](C& v) {
+            for (size_t i = 0; i < kMiddleOps; ++i) {
+                EraseMiddle(v);
+            }
+        });
+    }
+    runner.Run(prefix + "Reserve", n, n, filled, [n](C& v) {
+        ReserveFor(v, n * 2);
+    });
+    if constexpr (std::is_default_constructible_v<E>) {
+        runner.Run(prefix + "Resize", n, n, empty, [n](C& v) {
+            ResizeTo(v, n);
+        });
+    }
+    if constexpr (std::is_copy_constructible_v<E>) {
+        runner.Run(prefix + "CopyConstruct", n, n, filled, [](C& v) {
+            C copy(v);
+            DoNotOptimize(copy);
+        });
+    }
+    runner.Run(prefix + "MoveConstruct", n, n, filled, [](C& v) {
+        C moved(std::move(v));
+        DoNotOptimize(moved);
+        v = std::move(moved);
+    });
+    runner.Run(prefix + "Iterate", n, n, filled, [](C& v) {
+        size_t checksum = 0;
+        for (const auto& element : v) {
+            DoNotOptimize(element);
+            ++checksum;
+        }
+        DoNotOptimize(checksum);
+    });
+}
+
+template <typename E>
+void BenchmarkElement(Runner& runner, const std::string& element_name, size_t max_size) {
+    for (size_t n = 1; n <= max_size; n *= 10) {
+        BenchmarkContainer<Vector<E>, E>(runner, "Vector/" + element_name + "/", n);
+        BenchmarkContainer<std::vector<E>, E>(runner, "std::vector/" + element_name + "/", n);
+    }
+}
+
+// Also reports how often the buffer was reallocated and the share of the final
+// capacity left unused, both from an untimed run.
+template <typename Growth>
+void BenchmarkGrowth(Runner& runner, const std::string& policy_name, size_t max_size) {
+    using C = Vector<int, std::allocator<int>, Growth>;
+    std::string name = "Growth/" + policy_name + "/PushBack";
+    for (size_t n = 1; n <= max_size && runner.Matches(name); n *= 10) {
+        size_t reallocations = 0;
+        C sample;
+        for (size_t i = 0; i < n; ++i) {
+            size_t capacity = sample.Capacity();
+            sample.PushBack(static_cast<int>(i));
+            reallocations += (sample.Capacity() != capacity);
+        }
+        double waste = 100.0 * (sample.Capacity() - sample.Size()) / sample.Capacity();
+
+        runner.Run(name, n, n, [] { return C(); }, [n](C& v) {
+            for (size_t i = 0; i < n; ++i) {
+                v.PushBack(static_cast<int>(i));
+            }
+        }, {{"reallocations", static_cast<double>(reallocations)}, {"waste_pct", waste}});
+    }
+}
+
+template <typename Alloc, typename MakeAlloc, typename EndRequest>
+void BenchmarkRequest(Runner& runner, const std::string& name, size_t n, MakeAlloc make_alloc, EndRequest end_request) {
+    runner.Run("Request/" + name, n, n * kVectorsPerRequest, [] { return 0; }, [&](int&) {
+        for (size_t k = 0; k < kVectorsPerRequest; ++k) {
+            Vector<int, Alloc> v(make_alloc());
+            for (size_t i = 0; i < n; ++i) {
+                v.PushBack(static_cast<int>(i));
+            }
+            DoNotOptimize(v);
+        }
+        end_request();
+    });
+}
+
+void BenchmarkRequestLifecycle(Runner& runner, size_t max_size) {
+    MonotonicArena arena;
+    for (size_t n = 1; n <= std::min<size_t>(max_size, 100'000); n *= 10) {
+        BenchmarkRequest<std::allocator<int>>(runner, "std::allocator", n,
+            [] { return std::allocator<int>(); }, [] {});
+        BenchmarkRequest<ArenaAllocator<int>>(runner, "ArenaAllocator", n,
+            [&arena] { return ArenaAllocator<int>(arena); }, [&arena] { arena.Reset(); });
+        BenchmarkRequest<PoolAllocator<int>>(runner, "PoolAllocator", n,
+            [] { return PoolAllocator<int>(); }, [] {});
+    }
+}
+
+// Splits count pushes across threads; thread creation is part of the measurement.
+template <typename Push>
+void RunThreads(size_t threads, size_t count, Push push) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            for (size_t i = t; i < count; i += threads) {
+                push(static_cast<int>(i));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void BenchmarkConcurrentAppend(Runner& runner, size_t max_size) {
+    size_t count = std::min(max_size, kConcurrentPushes);
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        runner.Run("Concurrent/MutexVector/PushBack", threads, count,
+            [] { return std::make_unique<std::pair<std::mutex, Vector<int>>>(); },
+            [=](auto& state) {
+                RunThreads(threads, count, [&state](int value) {
+                    std::lock_guard lock(state->first);
+                    state->second.PushBack(value);
+                });
+            });
+        runner.Run("Concurrent/ConcurrentVector/PushBack", threads, count,
+            [] { return std::make_unique<ConcurrentVector<int>>(); },
+            [=](auto& state) {
+                RunThreads(threads, count, [&state](int value) {
+                    state->PushBack(value);
+                });
+            });
+    }
+}
+
+// Middle inserts into a vector with spare capacity, one element category per
+// shift strategy of Emplace: memmove, move assignment, move construction and
+// the copy into a second buffer.
+template <typename E>
+void BenchmarkMiddleInsert(Runner& runner, const std::string& category, size_t max_size) {
+    for (size_t n = 10; n <= std::min<size_t>(max_size, 100'000); n *= 10) {
+        runner.Run("MiddleInsert/" + category, n, n * kMiddleOps,
+            [n] {
+                Vector<E> v;
+                v.Reserve(n + kMiddleOps);
+                for (size_t i = 0; i < n; ++i) {
+                    v.EmplaceBack(MakeElement<E>(i));
+                }
+                return v;
+            },
+            [](Vector<E>& v) {
+                for (size_t i = 0; i < kMiddleOps; ++i) {
+                    v.Emplace(v.begin() + v.Size() / 2, MakeElement<E>(i));
+                }
+                DoNotOptimize(v.Size());
+            });
+    }
+}
+
+// Serial runs pass a threshold no range reaches.
+void BenchmarkParallelAlgorithms(Runner& runner, size_t max_size) {
+    for (size_t n = 10'000; n <= std::min<size_t>(max_size, 10'000'000); n *= 10) {
+        for (bool parallel : {false, true}) {
+            ParallelOptions options;
+            options.serial_threshold = parallel ? 0 : SIZE_MAX;
+            std::string suffix = parallel ? "Parallel" : "Serial";
+
+            runner.Run("Algorithms/Reduce/" + suffix, n, n,
+                [n] { return Vector<double>(n); },
+                [options](auto& values) {
+                    DoNotOptimize(ParallelReduce(values.begin(), values.end(), 0.0, std::plus<>{}, options));
+                });
+            runner.Run("Algorithms/Sort/" + suffix, n, n,
+                [n] {
+                    Vector<int> values(n, kDefaultInit);
+                    for (size_t i = 0; i < n; ++i) {
+                        values[i] = static_cast<int>((i * 2654435761u) % n);
+                    }
+                    return values;
+                },
+                [options](auto& values) {
+                    ParallelSort(values.begin(), values.end(), std::less<>{}, options);
+                    DoNotOptimize(values[0]);
+                });
+        }
+    }
+}
+
+template <typename Bulk>
+void BenchmarkBulk(Runner& runner, const std::string& name, size_t max_size) {
+    using BulkVector = Vector<double, std::allocator<double>, DoublingGrowth, Bulk>;
+    for (size_t n = 100'000; n <= std::min<size_t>(max_size, 100'000'000); n *= 10) {
+        runner.Run("Bulk/" + name + "/ConstructDestroy", n, n,
+            [] { return 0; },
+            [n](int&) {
+                BulkVector values(n);
+                DoNotOptimize(values[n - 1]);
+            });
+        runner.Run("Bulk/" + name + "/CopyConstruct", n, n,
+            [n] { return BulkVector(n); },
+            [](auto& values) {
+                BulkVector copy(values);
+                DoNotOptimize(copy[0]);
+            });
+    }
+}
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            options.json = true;
+        }
+        else if (std::strncmp(argv[i], "--max-size=", 11) == 0) {
+            options.max_size = std::strtoull(argv[i] + 11, nullptr, 10);
+        }
+        else if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            options.filter = argv[i] + 9;
+        }
+        else {
+            std::fprintf(stderr, "usage: %s [--json] [--max-size=N] [--filter=SUBSTRING]\n", argv[0]);
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    Runner runner(options);
+
+    BenchmarkElement<int>(runner, "int", options.max_size);
+    BenchmarkElement<std::unique_ptr<int>>(runner, "unique_ptr", options.max_size);
+    BenchmarkElement<ThrowingMove>(runner, "throwing_move", options.max_size);
+
+    BenchmarkMiddleInsert<int>(runner, "trivially_copyable", options.max_size);
+    BenchmarkMiddleInsert<std::unique_ptr<int>>(runner, "nothrow_move", options.max_size);
+    BenchmarkMiddleInsert<NonAssignable>(runner, "nothrow_move_non_assignable", options.max_size);
+    BenchmarkMiddleInsert<ThrowingMove>(runner, "throwing_move", options.max_size);
+
+    BenchmarkGrowth<DoublingGrowth>(runner, "x2", options.max_size);
+    BenchmarkGrowth<OneAndHalfGrowth>(runner, "x1.5", options.max_size);
+    BenchmarkGrowth<GoldenRatioGrowth>(runner, "golden", options.max_size);
+    BenchmarkGrowth<PageRoundedGrowth<>>(runner, "page_rounded", options.max_size);
+    BenchmarkGrowth<SizeClassGrowth<>>(runner, "size_class", options.max_size);
+    BenchmarkGrowth<FixedIncrementGrowth<4096>>(runner, "fixed_4096", options.max_size);
+
+    BenchmarkRequestLifecycle(runner, options.max_size);
+    BenchmarkConcurrentAppend(runner, options.max_size);
+    BenchmarkParallelAlgorithms(runner, options.max_size);
+    BenchmarkBulk<SerialBulk>(runner, "Serial", options.max_size);
+    BenchmarkBulk<ParallelBulk<>>(runner, "Parallel", options.max_size);
+
+    runner.Finish();
     return 0;
 }
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "growth_policy.h"
+#include "vector_file.h"
+
+// Vector whose elements live in a memory-mapped file, so data sets larger than
+// RAM can be appended to and reopened at startup without a deserialization pass.
+// The element count is kept in the file header; the file's length is the
+// capacity. Growth extends the file and remaps it, which invalidates iterators
+// and references just like a reallocation. Changes reach the file through the
+// shared mapping; Flush() forces them to disk. Linux only.
+template <typename T, typename Growth = DoublingGrowth>
+class MappedVector {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are stored as raw bytes");
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // Opens the vector stored at path, creating an empty one if the file doesn't exist.
+    explicit MappedVector(const std::string& path) {
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+
+        try {
+            struct stat st;
+            if (fstat(fd_, &st) != 0) {
+                throw std::system_error(errno, std::generic_category(), "fstat " + path);
+            }
+
+            if (st.st_size == 0) {
+                Truncate(FileSize(0));
+                Map(FileSize(0));
+                *Header() = MakeVectorFileHeader<T>(0);
+            }
+            else {
+                if (static_cast<size_t>(st.st_size) < sizeof(VectorFileHeader)) {
+                    throw std::runtime_error("not a vector file: " + path);
+                }
+                Map(static_cast<size_t>(st.st_size));
+                CheckVectorFileHeader<T>(*Header(), mapping_size_);
+            }
+        }
+        catch (...) {
+            Close();
+            throw;
+        }
+    }
+
+    MappedVector(const MappedVector&) = delete;
+    MappedVector& operator=(const MappedVector&) = delete;
+
+    MappedVector(MappedVector&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1))
+        , mapping_(std::exchange(other.mapping_, nullptr))
+        , mapping_size_(std::exchange(other.mapping_size_, 0)) {
+    }
+
+    MappedVector& operator=(MappedVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Close();
+            fd_ = std::exchange(rhs.fd_, -1);
+            mapping_ = std::exchange(rhs.mapping_, nullptr);
+            mapping_size_ = std::exchange(rhs.mapping_size_, 0);
+        }
+        return *this;
+    }
+
+    ~MappedVector() {
+        Close();
+    }
+
+    iterator begin() noexcept {
+        return Data();
+    }
+    iterator end() noexcept {
+        return Data() + Size();
+    }
+    const_iterator begin() const noexcept {
+        return const_cast<MappedVector&>(*this).begin();
+    }
+    const_iterator end() const noexcept {
+        return const_cast<MappedVector&>(*this).end();
+    }
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        // Build the element first: args may refer into the mapping, which growth can move.
+        T element(std::forward<Args>(args)...);
+        if (Size() == Capacity()) {
+            Reserve(Growth::NextCapacity(Capacity(), sizeof(T)));
+        }
+        T* slot = new (end()) T(element);
+        ++Header()->count;
+        return *slot;
+    }
+
+    void PopBack() noexcept {
+        assert(Size() > 0);
+        --Header()->count;
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size > Size()) {
+            Reserve(new_size);
+            std::uninitialized_value_construct_n(end(), new_size - Size());
+        }
+        Header()->count = new_size;
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+
+        size_t new_size = FileSize(new_capacity);
+        Truncate(new_size);
+        void* remapped = mremap(mapping_, mapping_size_, new_size, MREMAP_MAYMOVE);
+        if (remapped == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mremap");
+        }
+        mapping_ = static_cast<unsigned char*>(remapped);
+        mapping_size_ = new_size;
+    }
+
+    // Blocks until every modified page has been written to the file.
+    void Flush() {
+        if (msync(mapping_, mapping_size_, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync");
+        }
+    }
+
+    // Schedules write-back of modified pages without waiting for it.
+    void FlushAsync() {
+        if (msync(mapping_, mapping_size_, MS_ASYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync");
+        }
+    }
+
+    size_t Size() const noexcept {
+        return static_cast<size_t>(Header()->count);
+    }
+
+    size_t Capacity() const noexcept {
+        return (mapping_size_ - sizeof(VectorFileHeader)) / sizeof(T);
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<MappedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Size());
+        return Data()[index];
+    }
+
+private:
+    static size_t FileSize(size_t capacity) noexcept {
+        return sizeof(VectorFileHeader) + capacity * sizeof(T);
+    }
+
+    VectorFileHeader* Header() const noexcept {
+        return reinterpret_cast<VectorFileHeader*>(mapping_);
+    }
+
+    T* Data() const noexcept {
+        return reinterpret_cast<T*>(mapping_ + sizeof(VectorFileHeader));
+    }
+
+    void Truncate(size_t size) {
+        if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        }
+    }
+
+    void Map(size_t size) {
+        void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        mapping_ = static_cast<unsigned char*>(mapping);
+        mapping_size_ = size;
+    }
+
+    void Close() noexcept {
+        if (mapping_ != nullptr) {
+            munmap(mapping_, mapping_size_);
+            mapping_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    unsigned char* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
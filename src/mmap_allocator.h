@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Options for MmapAllocator.
+enum MmapFlags : unsigned {
+    kMmapDefault = 0,
+    // Pre-fault the whole mapping up front (MAP_POPULATE) instead of taking a
+    // page fault on first touch.
+    kMmapPopulate = 1u << 0,
+    // Try explicit hugetlbfs pages (MAP_HUGETLB) first; falls back to
+    // transparent huge pages when none are reserved.
+    kMmapHugeTlb = 1u << 1,
+};
+
+// Allocator for very large vectors. Buffers of at least ThresholdBytes are
+// anonymous mappings aligned to and advised for 2 MiB transparent huge pages,
+// which cuts TLB misses; smaller ones come from operator new. Its reallocate()
+// grows mappings with mremap, so Vector extends trivially relocatable buffers
+// by remapping pages rather than copying elements. Linux only.
+template <typename T, size_t ThresholdBytes = size_t{1} << 21, unsigned Flags = kMmapDefault>
+class MmapAllocator {
+public:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "small blocks use the default new alignment");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = MmapAllocator<U, ThresholdBytes, Flags>;
+    };
+
+    MmapAllocator() = default;
+
+    template <typename U>
+    MmapAllocator(const MmapAllocator<U, ThresholdBytes, Flags>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (!IsMapped(bytes)) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        return static_cast<T*>(Map(MappingSize(bytes)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        size_t bytes = n * sizeof(T);
+        if (!IsMapped(bytes)) {
+            ::operator delete(ptr);
+            return;
+        }
+        munmap(ptr, MappingSize(bytes));
+    }
+
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        size_t old_bytes = old_n * sizeof(T);
+        size_t new_bytes = new_n * sizeof(T);
+
+        // hugetlbfs mappings can't be resized portably, so they take the copy path.
+        if (IsMapped(old_bytes) && IsMapped(new_bytes) && !(Flags & kMmapHugeTlb)) {
+            size_t old_size = MappingSize(old_bytes);
+            size_t new_size = MappingSize(new_bytes);
+            if (old_size == new_size) {
+                return ptr;
+            }
+            void* remapped = mremap(ptr, old_size, new_size, 0);
+            if (remapped == MAP_FAILED) {
+                // Can't grow in place. Letting the kernel pick the new address
+                // would lose the 2 MiB alignment, so move into an aligned
+                // reservation instead; MREMAP_FIXED replaces it.
+                void* target = MapAligned(new_size, MAP_PRIVATE | MAP_ANONYMOUS);
+                remapped = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+                if (remapped == MAP_FAILED) {
+                    munmap(target, new_size);
+                    throw std::bad_alloc();
+                }
+            }
+            if (new_size > old_size) {
+                // The grown tail is fresh memory: advise and pre-fault it as Map does.
+                void* tail = static_cast<unsigned char*>(remapped) + old_size;
+                madvise(tail, new_size - old_size, MADV_HUGEPAGE);
+                if (Flags & kMmapPopulate) {
+                    Populate(tail, new_size - old_size);
+                }
+            }
+            return static_cast<T*>(remapped);
+        }
+
+        T* new_ptr = allocate(new_n);
+        std::memcpy(static_cast<void*>(new_ptr), static_cast<const void*>(ptr), std::min(old_bytes, new_bytes));
+        deallocate(ptr, old_n);
+        return new_ptr;
+    }
+
+    template <typename U>
+    bool operator==(const MmapAllocator<U, ThresholdBytes, Flags>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const MmapAllocator<U, ThresholdBytes, Flags>&) const noexcept {
+        return false;
+    }
+
+private:
+    static constexpr size_t kHugePageSize = size_t{1} << 21;
+
+    static bool IsMapped(size_t bytes) noexcept {
+        return bytes != 0 && bytes >= ThresholdBytes;
+    }
+
+    static size_t MappingSize(size_t bytes) noexcept {
+        size_t granularity = (Flags & kMmapHugeTlb) ? kHugePageSize : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + granularity - 1) / granularity * granularity;
+    }
+
+    static void* Map(size_t size) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | ((Flags & kMmapPopulate) ? MAP_POPULATE : 0);
+
+        if (Flags & kMmapHugeTlb) {
+            void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                return ptr;
+            }
+        }
+
+        void* ptr = MapAligned(size, flags & ~MAP_POPULATE);
+        madvise(ptr, size, MADV_HUGEPAGE);
+        if (Flags & kMmapPopulate) {
+            // MAP_POPULATE on the padded mapping would fault the trimmed ends too.
+            Populate(ptr, size);
+        }
+        return ptr;
+    }
+
+    // Over-maps by a huge page and trims both ends so the region starts on a
+    // 2 MiB boundary, which the kernel needs to back it with huge pages.
+    static void* MapAligned(size_t size, int flags) {
+        size_t padded = size + kHugePageSize;
+        void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + kHugePageSize - 1) & ~(uintptr_t{kHugePageSize} - 1);
+        if (aligned != start) {
+            munmap(raw, aligned - start);
+        }
+        size_t tail = (start + padded) - (aligned + size);
+        if (tail != 0) {
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    static void Populate(void* ptr, size_t size) noexcept {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#endif
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (size_t offset = 0; offset < size; offset += page_size) {
+            static_cast<volatile unsigned char*>(ptr)[offset] = 0;
+        }
+    }
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "vector.h"
+
+// NUMA placement goes through the raw mbind/get_mempolicy/move_pages system
+// calls, so nothing needs to link libnuma. On kernels without NUMA support,
+// or where the calls are filtered, placement is skipped and memory behaves
+// like any other anonymous mapping. Nodes 0..63 are supported.
+
+namespace numa_detail {
+
+inline constexpr size_t kMaxNodes = 64;
+
+inline size_t PageSize() noexcept {
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+inline size_t RoundUpToPage(size_t bytes) noexcept {
+    return (bytes + PageSize() - 1) & ~(PageSize() - 1);
+}
+
+// Nodes this process may allocate on; 0 when NUMA is unavailable.
+inline uint64_t AllowedNodes() noexcept {
+    static const uint64_t nodes = [] {
+        unsigned long mask = 0;
+        if (syscall(SYS_get_mempolicy, nullptr, &mask, kMaxNodes + 1, nullptr, MPOL_F_MEMS_ALLOWED) != 0) {
+            return uint64_t{0};
+        }
+        return uint64_t{mask};
+    }();
+    return nodes;
+}
+
+inline int CurrentNode() noexcept {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0 || node >= kMaxNodes) {
+        return -1;
+    }
+    return static_cast<int>(node);
+}
+
+// Failures are ignored: the pages just keep the default first-touch policy.
+inline void Bind(void* addr, size_t bytes, int mode, uint64_t nodes) noexcept {
+    unsigned long mask = nodes;
+    syscall(SYS_mbind, addr, bytes, mode, &mask, kMaxNodes + 1, 0);
+}
+
+}  // namespace numa_detail
+
+inline bool NumaAvailable() noexcept {
+    return numa_detail::AllowedNodes() != 0;
+}
+
+// Highest usable node id plus one; 1 without NUMA.
+inline size_t NumaNodeCount() noexcept {
+    uint64_t nodes = numa_detail::AllowedNodes();
+    size_t count = 1;
+    for (size_t node = 0; node < numa_detail::kMaxNodes; ++node) {
+        if (nodes >> node & 1) {
+            count = node + 1;
+        }
+    }
+    return count;
+}
+
+// Where the pages of a buffer go. Node sets are bit masks (bit n = node n);
+// an empty set means all nodes the process may use.
+class NumaPlacement {
+public:
+    // No policy: each page lands on the node of the thread that first touches it.
+    static NumaPlacement FirstTouch() noexcept {
+        return NumaPlacement(Kind::kFirstTouch, 0);
+    }
+
+    // The node of the thread that allocates the buffer.
+    static NumaPlacement Local() noexcept {
+        return NumaPlacement(Kind::kLocal, 0);
+    }
+
+    static NumaPlacement OnNode(size_t node) noexcept {
+        assert(node < numa_detail::kMaxNodes);
+        return NumaPlacement(Kind::kPreferred, uint64_t{1} << node);
+    }
+
+    // Pages go round-robin over the nodes, so every node sees the same mix of
+    // local and remote accesses.
+    static NumaPlacement Interleaved(uint64_t nodes = 0) noexcept {
+        return NumaPlacement(Kind::kInterleaved, nodes);
+    }
+
+    // The buffer is cut into equal contiguous parts, one per node in ascending
+    // order; pairs with workers that each process the matching slice.
+    static NumaPlacement Partitioned(uint64_t nodes = 0) noexcept {
+        return NumaPlacement(Kind::kPartitioned, nodes);
+    }
+
+    // Sets the policy of a fresh, page-aligned range; pages already touched
+    // stay where they are.
+    void Apply(void* addr, size_t bytes) const noexcept {
+        uint64_t allowed = numa_detail::AllowedNodes();
+        uint64_t nodes = (nodes_ != 0 ? nodes_ : allowed) & allowed;
+        if (nodes == 0 || kind_ == Kind::kFirstTouch) {
+            return;
+        }
+
+        if (kind_ == Kind::kLocal) {
+            int node = numa_detail::CurrentNode();
+            if (node >= 0) {
+                numa_detail::Bind(addr, bytes, MPOL_PREFERRED, uint64_t{1} << node);
+            }
+        }
+        else if (kind_ == Kind::kPreferred) {
+            numa_detail::Bind(addr, bytes, MPOL_PREFERRED, nodes);
+        }
+        else if (kind_ == Kind::kInterleaved) {
+            numa_detail::Bind(addr, bytes, MPOL_INTERLEAVE, nodes);
+        }
+        else {
+            size_t parts = std::bitset<numa_detail::kMaxNodes>(nodes).count();
+            size_t part_bytes = numa_detail::RoundUpToPage((bytes + parts - 1) / parts);
+            size_t offset = 0;
+            for (size_t node = 0; node < numa_detail::kMaxNodes && offset < bytes; ++node) {
+                if (nodes >> node & 1) {
+                    size_t length = std::min(part_bytes, bytes - offset);
+                    numa_detail::Bind(static_cast<char*>(addr) + offset, length, MPOL_PREFERRED, uint64_t{1} << node);
+                    offset += length;
+                }
+            }
+        }
+    }
+
+    friend bool operator==(const NumaPlacement& lhs, const NumaPlacement& rhs) noexcept {
+        return lhs.kind_ == rhs.kind_ && lhs.nodes_ == rhs.nodes_;
+    }
+    friend bool operator!=(const NumaPlacement& lhs, const NumaPlacement& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+private:
+    enum class Kind {
+        kFirstTouch,
+        kLocal,
+        kPreferred,
+        kInterleaved,
+        kPartitioned,
+    };
+
+    NumaPlacement(Kind kind, uint64_t nodes) noexcept
+        : kind_(kind)
+        , nodes_(nodes) {
+    }
+
+    Kind kind_;
+    uint64_t nodes_;
+};
+
+// Allocator that places buffers of a page or more according to a
+// NumaPlacement. They are anonymous mappings whose policy is set before any
+// page is touched, so it holds no matter which thread constructs the
+// elements; smaller buffers come from operator new. Any instance can free any
+// block, so containers with different placements still swap and move freely.
+//
+//     Vector<double, NumaAllocator<double>> values(NumaAllocator<double>(NumaPlacement::Interleaved()));
+template <typename T>
+class NumaAllocator {
+public:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "small blocks use the default new alignment");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    NumaAllocator() noexcept = default;
+
+    explicit NumaAllocator(NumaPlacement placement) noexcept
+        : placement_(placement) {
+    }
+
+    template <typename U>
+    NumaAllocator(const NumaAllocator<U>& other) noexcept
+        : placement_(other.Placement()) {
+    }
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < numa_detail::PageSize()) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        size_t size = numa_detail::RoundUpToPage(bytes);
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        placement_.Apply(ptr, size);
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        size_t bytes = n * sizeof(T);
+        if (bytes < numa_detail::PageSize()) {
+            ::operator delete(ptr);
+            return;
+        }
+        munmap(ptr, numa_detail::RoundUpToPage(bytes));
+    }
+
+    const NumaPlacement& Placement() const noexcept {
+        return placement_;
+    }
+
+    friend bool operator==(const NumaAllocator&, const NumaAllocator&) noexcept {
+        return true;
+    }
+    friend bool operator!=(const NumaAllocator&, const NumaAllocator&) noexcept {
+        return false;
+    }
+
+private:
+    NumaPlacement placement_ = NumaPlacement::FirstTouch();
+};
+
+struct NumaPageCounts {
+    // pages_per_node[n] is the number of resident pages on node n.
+    Vector<size_t> pages_per_node;
+    // Pages not faulted in yet; all of them when NUMA is unavailable.
+    size_t unknown = 0;
+};
+
+// Reports on which node each page of [data, data + bytes) currently lives.
+inline NumaPageCounts NumaPageDistribution(const void* data, size_t bytes) {
+    NumaPageCounts counts;
+    counts.pages_per_node.Resize(NumaNodeCount());
+    if (bytes == 0) {
+        return counts;
+    }
+
+    size_t page_size = numa_detail::PageSize();
+    uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+    size_t total = (reinterpret_cast<uintptr_t>(data) + bytes - first + page_size - 1) / page_size;
+
+    constexpr size_t kBatch = 1024;
+    void* pages[kBatch];
+    int status[kBatch];
+    for (size_t done = 0; done < total;) {
+        size_t batch = std::min(kBatch, total - done);
+        for (size_t i = 0; i < batch; ++i) {
+            pages[i] = reinterpret_cast<void*>(first + (done + i) * page_size);
+        }
+        // With no target nodes move_pages only reports each page's node.
+        if (!NumaAvailable() || syscall(SYS_move_pages, 0, batch, pages, nullptr, status, 0) != 0) {
+            counts.unknown += total - done;
+            break;
+        }
+        for (size_t i = 0; i < batch; ++i) {
+            if (status[i] >= 0 && static_cast<size_t>(status[i]) < counts.pages_per_node.Size()) {
+                ++counts.pages_per_node[static_cast<size_t>(status[i])];
+            }
+            else {
+                ++counts.unknown;
+            }
+        }
+        done += batch;
+    }
+    return counts;
+}
+
+template <typename T, typename Alloc, typename Growth, typename Bulk>
+NumaPageCounts NumaPageDistribution(const Vector<T, Alloc, Growth, Bulk>& vector) {
+    return NumaPageDistribution(vector.begin(), vector.Size() * sizeof(T));
+}
@@ -0,0 +1,471 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "vector.h"
+
+// Work-stealing thread pool: each worker owns a task deque, pops its own work
+// from the back and steals from the front of the others' when it runs dry.
+// Threads waiting for a batch of tasks help by running queued tasks too, so
+// nested parallel calls can't deadlock the pool.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < threads; ++i) {
+            queues_.EmplaceBack(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.EmplaceBack([this, i] {
+                WorkerLoop(i);
+            });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(wake_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    static ThreadPool& Default() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    size_t ThreadCount() const noexcept {
+        return workers_.Size();
+    }
+
+    void Submit(std::function<void()> task) {
+        Queue& queue = *queues_[next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.Size()];
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard lock(wake_mutex_);
+            ++pending_;
+        }
+        wake_.notify_one();
+    }
+
+    // Runs one queued task on the calling thread; false if there was none.
+    bool RunPendingTask() {
+        std::function<void()> task;
+        if (!Steal(queues_.Size(), task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void WorkerLoop(size_t index) {
+        while (true) {
+            std::function<void()> task;
+            if (PopOwn(index, task) || Steal(index, task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock lock(wake_mutex_);
+            wake_.wait(lock, [this] {
+                return stop_ || pending_ > 0;
+            });
+            if (stop_ && pending_ == 0) {
+                return;
+            }
+        }
+    }
+
+    bool PopOwn(size_t index, std::function<void()>& task) {
+        Queue& queue = *queues_[index];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        TakePending();
+        return true;
+    }
+
+    // Takes the oldest task of any queue other than skip.
+    bool Steal(size_t skip, std::function<void()>& task) {
+        for (size_t offset = 1; offset <= queues_.Size(); ++offset) {
+            size_t victim = (skip + offset) % queues_.Size();
+            if (victim == skip) {
+                continue;
+            }
+            Queue& queue = *queues_[victim];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                TakePending();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TakePending() {
+        std::lock_guard lock(wake_mutex_);
+        --pending_;
+    }
+
+    Vector<std::unique_ptr<Queue>> queues_;
+    Vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    size_t pending_ = 0;
+    bool stop_ = false;
+};
+
+struct ParallelOptions {
+    // Ranges shorter than this run serially on the calling thread.
+    size_t serial_threshold = size_t{1} << 15;
+    // Elements per task; 0 picks a size from the range and the pool.
+    size_t chunk_size = 0;
+    // Makes chunk boundaries independent of the number of threads, so
+    // ParallelReduce combines the same partial results in the same order on
+    // every machine (matters for floating-point sums).
+    bool deterministic = false;
+    // Defaults to ThreadPool::Default().
+    ThreadPool* pool = nullptr;
+};
+
+namespace parallel_detail {
+
+// Each task covers at least this many bytes, so chunks don't share cache lines
+// and per-task overhead stays small.
+inline constexpr size_t kMinChunkBytes = 64 * 1024;
+
+template <typename It>
+size_t ChunkSize(size_t count, const ParallelOptions& options, const ThreadPool& pool) {
+    if (options.chunk_size != 0) {
+        return options.chunk_size;
+    }
+    using Value = typename std::iterator_traits<It>::value_type;
+    size_t min_chunk = std::max<size_t>(1, kMinChunkBytes / sizeof(Value));
+    if (options.deterministic) {
+        return min_chunk;
+    }
+    // A few chunks per thread leave room for stealing to even out the load.
+    return std::max(min_chunk, count / (pool.ThreadCount() * 4));
+}
+
+// Runs body(chunk_index, chunk_first, chunk_last) for every chunk of
+// [first, last) on the pool and waits for all of them; the first exception
+// thrown by a chunk is rethrown here once the others have finished. Nothing
+// else throws: chunks that can't be queued run on the calling thread.
+template <typename It, typename Body>
+void ForEachChunk(It first, It last, size_t chunk_size, ThreadPool& pool, Body body) {
+    size_t count = static_cast<size_t>(last - first);
+    size_t chunks = (count + chunk_size - 1) / chunk_size;
+    if (chunks == 0) {
+        return;
+    }
+
+    struct Batch {
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    } batch;
+    batch.remaining.store(chunks, std::memory_order_relaxed);
+
+    auto run_chunk = [&batch, &body, first, count, chunk_size](size_t chunk) {
+        std::exception_ptr error;
+        try {
+            It chunk_first = first + chunk * chunk_size;
+            It chunk_last = first + std::min(count, (chunk + 1) * chunk_size);
+            body(chunk, chunk_first, chunk_last);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        // Counting down under the mutex means the batch can't be destroyed
+        // before the last chunk is done touching it.
+        std::lock_guard lock(batch.mutex);
+        if (error && !batch.error) {
+            batch.error = error;
+        }
+        if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            batch.done.notify_all();
+        }
+    };
+
+    // The calling thread takes the first chunk itself.
+    size_t submitted = 1;
+    try {
+        for (; submitted < chunks; ++submitted) {
+            pool.Submit([&run_chunk, chunk = submitted] {
+                run_chunk(chunk);
+            });
+        }
+    }
+    catch (...) {
+    }
+    run_chunk(0);
+    for (size_t chunk = submitted; chunk < chunks; ++chunk) {
+        run_chunk(chunk);
+    }
+
+    // Help with queued work, then sleep once there is nothing left to steal.
+    while (batch.remaining.load(std::memory_order_acquire) != 0) {
+        if (!pool.RunPendingTask()) {
+            break;
+        }
+    }
+    std::unique_lock lock(batch.mutex);
+    batch.done.wait(lock, [&batch] {
+        return batch.remaining.load(std::memory_order_acquire) == 0;
+    });
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+inline ThreadPool& PoolFor(const ParallelOptions& options) {
+    return options.pool != nullptr ? *options.pool : ThreadPool::Default();
+}
+
+}  // namespace parallel_detail
+
+// Parallel counterparts of the std algorithms for random-access ranges such as
+// [Vector::begin(), Vector::end()). Each splits the range into chunks run on
+// a ThreadPool and falls back to the serial algorithm below
+// options.serial_threshold elements.
+
+template <typename It, typename F>
+void ParallelForEach(It first, It last, F f, const ParallelOptions& options = {}) {
+    size_t count = static_cast<size_t>(last - first);
+    if (count < options.serial_threshold) {
+        std::for_each(first, last, f);
+        return;
+    }
+    ThreadPool& pool = parallel_detail::PoolFor(options);
+    parallel_detail::ForEachChunk(first, last, parallel_detail::ChunkSize<It>(count, options, pool), pool,
+        [&f](size_t, It chunk_first, It chunk_last) {
+            std::for_each(chunk_first, chunk_last, f);
+        });
+}
+
+template <typename It, typename OutIt, typename F>
+OutIt ParallelTransform(It first, It last, OutIt out, F f, const ParallelOptions& options = {}) {
+    size_t count = static_cast<size_t>(last - first);
+    if (count < options.serial_threshold) {
+        return std::transform(first, last, out, f);
+    }
+    ThreadPool& pool = parallel_detail::PoolFor(options);
+    parallel_detail::ForEachChunk(first, last, parallel_detail::ChunkSize<It>(count, options, pool), pool,
+        [&f, first, out](size_t, It chunk_first, It chunk_last) {
+            std::transform(chunk_first, chunk_last, out + (chunk_first - first), f);
+        });
+    return out + count;
+}
+
+template <typename It, typename T>
+void ParallelFill(It first, It last, const T& value, const ParallelOptions& options = {}) {
+    size_t count = static_cast<size_t>(last - first);
+    if (count < options.serial_threshold) {
+        std::fill(first, last, value);
+        return;
+    }
+    ThreadPool& pool = parallel_detail::PoolFor(options);
+    parallel_detail::ForEachChunk(first, last, parallel_detail::ChunkSize<It>(count, options, pool), pool,
+        [&value](size_t, It chunk_first, It chunk_last) {
+            std::fill(chunk_first, chunk_last, value);
+        });
+}
+
+// op must be associative. Every chunk is folded on its own and the partial
+// results are combined left to right, starting from init.
+template <typename It, typename T, typename Op = std::plus<>>
+T ParallelReduce(It first, It last, T init, Op op = {}, const ParallelOptions& options = {}) {
+    size_t count = static_cast<size_t>(last - first);
+    if (count < options.serial_threshold) {
+        for (; first != last; ++first) {
+            init = op(std::move(init), *first);
+        }
+        return init;
+    }
+
+    ThreadPool& pool = parallel_detail::PoolFor(options);
+    size_t chunk_size = parallel_detail::ChunkSize<It>(count, options, pool);
+    Vector<std::optional<T>> partials((count + chunk_size - 1) / chunk_size);
+
+    parallel_detail::ForEachChunk(first, last, chunk_size, pool,
+        [&partials, &op](size_t chunk, It chunk_first, It chunk_last) {
+            T partial = *chunk_first;
+            for (++chunk_first; chunk_first != chunk_last; ++chunk_first) {
+                partial = op(std::move(partial), *chunk_first);
+            }
+            partials[chunk].emplace(std::move(partial));
+        });
+
+    for (auto& partial : partials) {
+        init = op(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+// Sorts chunks in parallel, then merges neighbouring runs pairwise, doubling
+// the run length each round. Not stable.
+template <typename It, typename Compare = std::less<>>
+void ParallelSort(It first, It last, Compare comp = {}, const ParallelOptions& options = {}) {
+    size_t count = static_cast<size_t>(last - first);
+    if (count < options.serial_threshold) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    ThreadPool& pool = parallel_detail::PoolFor(options);
+    size_t run = parallel_detail::ChunkSize<It>(count, options, pool);
+    parallel_detail::ForEachChunk(first, last, run, pool,
+        [&comp](size_t, It chunk_first, It chunk_last) {
+            std::sort(chunk_first, chunk_last, comp);
+        });
+
+    for (; run < count; run *= 2) {
+        // Each task merges two adjacent runs of the current length.
+        parallel_detail::ForEachChunk(first, last, run * 2, pool,
+            [&comp, run](size_t, It pair_first, It pair_last) {
+                if (static_cast<size_t>(pair_last - pair_first) > run) {
+                    std::inplace_merge(pair_first, pair_first + run, pair_last, comp);
+                }
+            });
+    }
+}
+
+// Bulk policy for Vector (its fourth template argument) that splits
+// construction, copying, relocation and destruction of Threshold or more
+// elements across ThreadPool::Default(). Every thread first-touches the pages
+// it writes, so on a NUMA machine a big vector is spread over the nodes of
+// the pool's threads instead of landing on the node of the constructing one.
+//
+//     Vector<double, std::allocator<double>, DoublingGrowth, ParallelBulk<>> values(size_t{1} << 30);
+//
+// If constructing an element throws, the chunks already built are destroyed
+// and the first exception is rethrown, as with the serial algorithms.
+template <size_t Threshold = (size_t{1} << 16)>
+struct ParallelBulk {
+    template <typename T>
+    static void ValueConstruct(T* first, size_t count) {
+        ConstructChunks(first, count, [first](size_t offset, size_t n) {
+            std::uninitialized_value_construct_n(first + offset, n);
+        });
+    }
+
+    template <typename T>
+    static void DefaultConstruct(T* first, size_t count) {
+        if constexpr (std::is_trivially_default_constructible_v<T>) {
+            // Nothing is written, so there is nothing to spread out.
+            return;
+        }
+        ConstructChunks(first, count, [first](size_t offset, size_t n) {
+            std::uninitialized_default_construct_n(first + offset, n);
+        });
+    }
+
+    template <typename T>
+    static void Copy(const T* from, size_t count, T* to) {
+        ConstructChunks(to, count, [from, to](size_t offset, size_t n) {
+            std::uninitialized_copy_n(from + offset, n, to + offset);
+        });
+    }
+
+    template <typename T>
+    static void Move(T* from, size_t count, T* to) {
+        ConstructChunks(to, count, [from, to](size_t offset, size_t n) {
+            std::uninitialized_move_n(from + offset, n, to + offset);
+        });
+    }
+
+    template <typename T>
+    static void CopyBytes(const T* from, size_t count, T* to) noexcept {
+        ForChunks(to, count, [from, to](size_t offset, size_t n) noexcept {
+            SerialBulk::CopyBytes(from + offset, n, to + offset);
+        });
+    }
+
+    template <typename T>
+    static void Destroy(T* first, size_t count) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            ForChunks(first, count, [first](size_t offset, size_t n) noexcept {
+                std::destroy_n(first + offset, n);
+            });
+        }
+    }
+
+private:
+    // Calls op(offset, n) for the chunks of [first, first + count), serially
+    // below Threshold.
+    template <typename T, typename Op>
+    static void ForChunks(T* first, size_t count, Op op) {
+        if (count < Threshold) {
+            op(0, count);
+            return;
+        }
+        ThreadPool& pool = ThreadPool::Default();
+        size_t chunk_size = parallel_detail::ChunkSize<T*>(count, ParallelOptions{}, pool);
+        parallel_detail::ForEachChunk(first, first + count, chunk_size, pool,
+            [first, &op](size_t, T* chunk_first, T* chunk_last) {
+                op(static_cast<size_t>(chunk_first - first), static_cast<size_t>(chunk_last - chunk_first));
+            });
+    }
+
+    // Like ForChunks for construct(offset, n), which cleans up its own chunk
+    // when it throws; the chunks that did succeed are destroyed here.
+    template <typename T, typename Construct>
+    static void ConstructChunks(T* first, size_t count, Construct construct) {
+        if (count < Threshold) {
+            construct(0, count);
+            return;
+        }
+        ThreadPool& pool = ThreadPool::Default();
+        size_t chunk_size = parallel_detail::ChunkSize<T*>(count, ParallelOptions{}, pool);
+        Vector<char> built((count + chunk_size - 1) / chunk_size);
+        try {
+            parallel_detail::ForEachChunk(first, first + count, chunk_size, pool,
+                [first, &construct, &built](size_t chunk, T* chunk_first, T* chunk_last) {
+                    construct(static_cast<size_t>(chunk_first - first), static_cast<size_t>(chunk_last - chunk_first));
+                    built[chunk] = 1;
+                });
+        }
+        catch (...) {
+            for (size_t chunk = 0; chunk < built.Size(); ++chunk) {
+                if (built[chunk]) {
+                    std::destroy_n(first + chunk * chunk_size, std::min(chunk_size, count - chunk * chunk_size));
+                }
+            }
+            throw;
+        }
+    }
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <iterator>
+
+#include "vector.h"
+
+// Vector built from fixed-size RawMemory blocks listed in an index table.
+// Appending only ever adds a block, so elements are never relocated: their
+// addresses stay valid until they are removed, and a push costs at most one
+// block allocation no matter how large the container is. Random access is a
+// shift and a mask into the table.
+template <typename T, size_t BlockSize = 1024, typename Alloc = std::allocator<T>>
+class SegmentedVector {
+    static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0, "block size must be a power of two");
+
+    using Block = RawMemory<T, Alloc>;
+
+    template <bool IsConst>
+    class Iterator {
+        using Owner = std::conditional_t<IsConst, const SegmentedVector, SegmentedVector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        Iterator(Owner* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        operator Iterator<true>() const noexcept {
+            return Iterator<true>(owner_, index_);
+        }
+
+        reference operator*() const noexcept {
+            return (*owner_)[index_];
+        }
+        pointer operator->() const noexcept {
+            return &(*owner_)[index_];
+        }
+        reference operator[](difference_type offset) const noexcept {
+            return (*owner_)[index_ + offset];
+        }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            return Iterator(owner_, index_++);
+        }
+        Iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+        Iterator operator--(int) noexcept {
+            return Iterator(owner_, index_--);
+        }
+        Iterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+        Iterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+        friend Iterator operator+(Iterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+        friend Iterator operator+(difference_type offset, Iterator it) noexcept {
+            return it += offset;
+        }
+        friend Iterator operator-(Iterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+        friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+        friend bool operator>(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ > rhs.index_;
+        }
+        friend bool operator<=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ <= rhs.index_;
+        }
+        friend bool operator>=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ >= rhs.index_;
+        }
+
+    private:
+        Owner* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+    using allocator_type = Alloc;
+
+    static constexpr size_t kBlockSize = BlockSize;
+
+    SegmentedVector() = default;
+
+    explicit SegmentedVector(const Alloc& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    explicit SegmentedVector(const SegmentedVector& other)
+        : alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_))
+    {
+        Reserve(other.size_);
+        try {
+            for (const T& value : other) {
+                EmplaceBack(value);
+            }
+        }
+        catch (...) {
+            // The destructor won't run, so destroy the copies made so far.
+            Clear();
+            throw;
+        }
+    }
+
+    SegmentedVector(SegmentedVector&& other) noexcept
+        : alloc_(other.alloc_)
+        , blocks_(std::move(other.blocks_))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Clear();
+            alloc_ = rhs.alloc_;
+            blocks_ = std::move(rhs.blocks_);
+            size_ = std::exchange(rhs.size_, 0);
+        }
+        return *this;
+    }
+
+    ~SegmentedVector() {
+        Clear();
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    // Existing elements never move, so args may safely refer to them.
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            blocks_.EmplaceBack(BlockSize, alloc_);
+        }
+        T* slot = new (Slot(size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        std::destroy_at(Slot(size_ - 1));
+        --size_;
+    }
+
+    void Resize(size_t new_size) {
+        while (size_ > new_size) {
+            PopBack();
+        }
+        Reserve(new_size);
+        while (size_ < new_size) {
+            EmplaceBack();
+        }
+    }
+
+    void Reserve(size_t new_capacity) {
+        size_t blocks = (new_capacity + BlockSize - 1) / BlockSize;
+        blocks_.Reserve(blocks);
+        while (blocks_.Size() < blocks) {
+            blocks_.EmplaceBack(BlockSize, alloc_);
+        }
+    }
+
+    // Destroys the elements but keeps the blocks for reuse.
+    void Clear() noexcept {
+        for (size_t block = 0; block * BlockSize < size_; ++block) {
+            std::destroy_n(blocks_[block].GetAddress(), std::min(BlockSize, size_ - block * BlockSize));
+        }
+        size_ = 0;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return blocks_.Size() * BlockSize;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return *Slot(index);
+    }
+
+private:
+    T* Slot(size_t index) noexcept {
+        return blocks_[index / BlockSize] + (index % BlockSize);
+    }
+
+    Alloc alloc_;
+    Vector<Block> blocks_;
+    size_t size_ = 0;
+};
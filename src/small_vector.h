@@ -0,0 +1,325 @@
+#pragma once
+
+#include "vector.h"
+
+// Vector with inline storage for the first N elements; it spills to a
+// RawMemory buffer only when it outgrows them.
+template <typename T, size_t N, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth>
+class SmallVector {
+    static_assert(N > 0, "use Vector when no inline storage is wanted");
+
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+    using allocator_type = Alloc;
+
+    SmallVector() = default;
+
+    explicit SmallVector(const Alloc& alloc) noexcept
+        : heap_(alloc) {
+    }
+
+    explicit SmallVector(size_t size, const Alloc& alloc = Alloc())
+        : heap_(alloc) {
+        Resize(size);
+    }
+
+    SmallVector(const SmallVector& other)
+        : heap_(AllocTraits::select_on_container_copy_construction(other.heap_.GetAllocator()))
+    {
+        Reserve(other.size_);
+        std::uninitialized_copy_n(other.begin(), other.size_, begin());
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : heap_(other.heap_.GetAllocator())
+    {
+        if (other.IsInline()) {
+            Relocate(other.begin(), other.size_, begin());
+        }
+        else {
+            heap_.Swap(other.heap_);
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    iterator begin() noexcept {
+        return IsInline() ? reinterpret_cast<T*>(inline_) : heap_.GetAddress();
+    }
+    iterator end() noexcept {
+        return begin() + size_;
+    }
+    const_iterator begin() const noexcept {
+        return const_cast<SmallVector&>(*this).begin();
+    }
+    const_iterator end() const noexcept {
+        return begin() + size_;
+    }
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        size_t offset = (pos - cbegin());
+
+        if (size_ < Capacity()) {
+            if (offset == size_) {
+                new (begin() + offset) T(std::forward<Args>(args)...);
+            }
+            else if constexpr (vector_detail::kShiftsInPlace<T>) {
+                vector_detail::ShiftInsert(begin(), size_, offset, std::forward<Args>(args)...);
+            }
+            else {
+                // As in Vector: a throwing move can't shift in place with the
+                // strong guarantee, so this rebuilds into a fresh buffer of the
+                // same capacity, which also moves inline elements to the heap.
+                EmplaceInNewBuffer(Capacity(), offset, std::forward<Args>(args)...);
+            }
+        }
+        else {
+            EmplaceInNewBuffer(Growth::NextCapacity(Capacity(), sizeof(T)), offset, std::forward<Args>(args)...);
+        }
+
+        size_++;
+        return begin() + offset;
+    }
+
+    iterator Erase(const_iterator pos) {
+        return Erase(pos, pos + 1);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        size_t offset = (first - cbegin());
+        size_t count = (last - first);
+        if (count != 0) {
+            vector_detail::ShiftErase(begin(), size_, offset, count);
+            size_ -= count;
+        }
+        return begin() + offset;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+        }
+        else if (new_size > size_) {
+            Reserve(new_size);
+            std::uninitialized_value_construct_n(end(), (new_size - size_));
+        }
+        size_ = new_size;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return *Emplace(cend(), std::forward<Args>(args)...);
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        std::destroy_at(end() - 1);
+        size_--;
+    }
+
+    SmallVector& operator=(const SmallVector& rhs) {
+        if (this != &rhs) {
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+                if (heap_.GetAllocator() != rhs.heap_.GetAllocator()) {
+                    // Memory owned by the old allocator must be released through it.
+                    std::destroy_n(begin(), size_);
+                    size_ = 0;
+                    heap_ = RawMemory<T, Alloc>(rhs.heap_.GetAllocator());
+                }
+                heap_.GetAllocator() = rhs.heap_.GetAllocator();
+            }
+
+            if (rhs.size_ > Capacity()) {
+                RawMemory<T, Alloc> new_data(rhs.size_, heap_.GetAllocator());
+                std::uninitialized_copy_n(rhs.begin(), rhs.size_, new_data.GetAddress());
+                std::destroy_n(begin(), size_);
+                heap_.Swap(new_data);
+            }
+            else {
+                std::copy_n(rhs.begin(), std::min(rhs.size_, size_), begin());
+                if (rhs.size_ < size_) {
+                    std::destroy_n(begin() + rhs.size_, size_ - rhs.size_);
+                }
+                else {
+                    std::uninitialized_copy_n(rhs.begin() + size_, rhs.size_ - size_, end());
+                }
+            }
+            size_ = rhs.size_;
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                       && (AllocTraits::propagate_on_container_move_assignment::value
+                                                           || AllocTraits::is_always_equal::value)) {
+        if (this != &rhs) {
+            std::destroy_n(begin(), size_);
+            size_ = 0;
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                if (heap_.GetAllocator() != rhs.heap_.GetAllocator()) {
+                    heap_ = RawMemory<T, Alloc>(rhs.heap_.GetAllocator());
+                }
+                heap_.GetAllocator() = rhs.heap_.GetAllocator();
+            }
+
+            if (rhs.IsInline()) {
+                // Capacity never drops below N, so the elements always fit.
+                Relocate(rhs.begin(), rhs.size_, begin());
+            }
+            else if (heap_.GetAllocator() == rhs.heap_.GetAllocator()) {
+                heap_.Swap(rhs.heap_);
+            }
+            else {
+                // Unequal, non-propagating allocators: the buffer can't change hands.
+                Reserve(rhs.size_);
+                Relocate(rhs.begin(), rhs.size_, begin());
+            }
+            size_ = std::exchange(rhs.size_, 0);
+        }
+        return *this;
+    }
+
+    // Like Vector::Swap, the allocators must be equal unless they propagate on swap.
+    void Swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            heap_.SwapAllocator(other.heap_);
+        }
+        else {
+            assert(heap_.GetAllocator() == other.heap_.GetAllocator());
+        }
+
+        if (IsInline() && other.IsInline()) {
+            alignas(T) unsigned char temp[N * sizeof(T)];
+            Relocate(begin(), size_, reinterpret_cast<T*>(temp));
+            Relocate(other.begin(), other.size_, reinterpret_cast<T*>(inline_));
+            Relocate(reinterpret_cast<T*>(temp), size_, reinterpret_cast<T*>(other.inline_));
+        }
+        else if (IsInline() || other.IsInline()) {
+            // The inline elements move into the heap side's unused inline
+            // storage, then the heap buffer changes sides.
+            SmallVector& inline_side = IsInline() ? *this : other;
+            SmallVector& heap_side = IsInline() ? other : *this;
+            Relocate(inline_side.begin(), inline_side.size_, reinterpret_cast<T*>(heap_side.inline_));
+        }
+        heap_.Swap(other.heap_);
+        std::swap(size_, other.size_);
+    }
+
+    ~SmallVector() {
+        std::destroy_n(begin(), size_);
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+
+        RawMemory<T, Alloc> new_data(new_capacity, heap_.GetAllocator());
+        CopyData(begin(), size_, new_data.GetAddress());
+        std::destroy_n(begin(), size_);
+
+        heap_.Swap(new_data);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    bool IsInline() const noexcept {
+        return heap_.GetAddress() == nullptr;
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SmallVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return begin()[index];
+    }
+
+private:
+    template <typename... Args>
+    void EmplaceInNewBuffer(size_t capacity, size_t offset, Args&&... args) {
+        RawMemory<T, Alloc> new_data(capacity, heap_.GetAllocator());
+
+        new (new_data + offset) T(std::forward<Args>(args)...);
+
+        try {
+            CopyData(begin(), offset, new_data.GetAddress());
+        }
+        catch (...) {
+            std::destroy_at(new_data + offset);
+            throw;
+        }
+
+        try {
+            CopyData((begin() + offset), (size_ - offset), (new_data.GetAddress() + offset + 1));
+        }
+        catch (...) {
+            std::destroy_n(new_data.GetAddress(), offset + 1);
+            throw;
+        }
+
+        std::destroy_n(begin(), size_);
+        heap_.Swap(new_data);
+    }
+
+    static void CopyData(T* from, size_t count, T* to) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count != 0) {
+                std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+            }
+        }
+        else if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            std::uninitialized_move_n(from, count, to);
+        }
+        else {
+            std::uninitialized_copy_n(from, count, to);
+        }
+    }
+
+    // Moves count elements to uninitialized storage and destroys the originals.
+    static void Relocate(T* from, size_t count, T* to) {
+        CopyData(from, count, to);
+        std::destroy_n(from, count);
+    }
+
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+    RawMemory<T, Alloc> heap_;
+    size_t size_ = 0;
+};
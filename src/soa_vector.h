@@ -0,0 +1,214 @@
+#pragma once
+
+#include <tuple>
+
+#include "vector.h"
+
+// Structure-of-arrays container: each field lives in its own RawMemory and all
+// of them share one size and capacity, so a loop over a single field streams
+// through contiguous memory of just that field. Rows are accessed through a
+// tuple of references, which also works with structured bindings:
+//
+//     SoaVector<float, float, int> particles;
+//     particles.PushBack(1.0f, 2.0f, 3);
+//     auto [x, y, id] = particles[0];
+//     float* xs = particles.FieldData<0>();  // xs[0 .. Size())
+//
+// Fields must be nothrow movable, which keeps growth and Erase from failing
+// halfway through the columns.
+template <typename... Fields>
+class SoaVector {
+    static_assert(sizeof...(Fields) > 0);
+    static_assert((std::is_nothrow_move_constructible_v<Fields> && ...), "fields must be nothrow move constructible");
+    static_assert((std::is_nothrow_move_assignable_v<Fields> && ...), "fields must be nothrow move assignable");
+
+    using Storage = std::tuple<RawMemory<Fields>...>;
+    using Indices = std::index_sequence_for<Fields...>;
+
+    static constexpr size_t kRowSize = (sizeof(Fields) + ...);
+
+public:
+    using Reference = std::tuple<Fields&...>;
+    using ConstReference = std::tuple<const Fields&...>;
+
+    template <size_t I>
+    using FieldType = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    SoaVector() = default;
+
+    SoaVector(const SoaVector&) = delete;
+    SoaVector& operator=(const SoaVector&) = delete;
+
+    SoaVector(SoaVector&& other) noexcept
+        : data_(std::move(other.data_))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    SoaVector& operator=(SoaVector&& rhs) noexcept {
+        if (this != &rhs) {
+            DestroyRows(0, size_, Indices{});
+            data_ = std::move(rhs.data_);
+            size_ = std::exchange(rhs.size_, 0);
+        }
+        return *this;
+    }
+
+    ~SoaVector() {
+        DestroyRows(0, size_, Indices{});
+    }
+
+    void PushBack(Fields... values) {
+        EmplaceBack(std::move(values)...);
+    }
+
+    // Takes one constructor argument per field.
+    template <typename... Args>
+    Reference EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "one argument per field");
+
+        if (size_ < Capacity()) {
+            ConstructRow(data_, size_, Indices{}, std::forward<Args>(args)...);
+        }
+        else {
+            // The row is built before the old columns move, so args may refer into them.
+            Storage new_data = MakeStorage(DoublingGrowth::NextCapacity(Capacity(), kRowSize));
+            ConstructRow(new_data, size_, Indices{}, std::forward<Args>(args)...);
+            Relocate(new_data, Indices{});
+        }
+        ++size_;
+        return (*this)[size_ - 1];
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        DestroyRows(size_ - 1, size_, Indices{});
+        --size_;
+    }
+
+    void Erase(size_t index) noexcept {
+        assert(index < size_);
+        ShiftDown(index, Indices{});
+        PopBack();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+        Storage new_data = MakeStorage(new_capacity);
+        Relocate(new_data, Indices{});
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            DestroyRows(new_size, size_, Indices{});
+        }
+        else if (new_size > size_) {
+            Reserve(new_size);
+            ValueConstructRows(size_, new_size - size_, Indices{});
+        }
+        size_ = new_size;
+    }
+
+    void Clear() noexcept {
+        DestroyRows(0, size_, Indices{});
+        size_ = 0;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(data_).Capacity();
+    }
+
+    // Contiguous column of field I: [FieldData<I>(), FieldData<I>() + Size()).
+    template <size_t I>
+    FieldType<I>* FieldData() noexcept {
+        return std::get<I>(data_).GetAddress();
+    }
+
+    template <size_t I>
+    const FieldType<I>* FieldData() const noexcept {
+        return std::get<I>(data_).GetAddress();
+    }
+
+    template <size_t I>
+    FieldType<I>& Get(size_t index) noexcept {
+        assert(index < size_);
+        return std::get<I>(data_)[index];
+    }
+
+    template <size_t I>
+    const FieldType<I>& Get(size_t index) const noexcept {
+        assert(index < size_);
+        return std::get<I>(data_)[index];
+    }
+
+    Reference operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Row(index, Indices{});
+    }
+
+    ConstReference operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return const_cast<SoaVector&>(*this).Row(index, Indices{});
+    }
+
+private:
+    static Storage MakeStorage(size_t capacity) {
+        return Storage(RawMemory<Fields>(capacity)...);
+    }
+
+    // Constructs field I of the row from the I-th argument; on failure the
+    // fields built so far are destroyed again.
+    template <size_t... I, typename... Args>
+    static void ConstructRow(Storage& storage, size_t index, std::index_sequence<I...>, Args&&... args) {
+        size_t constructed = 0;
+        try {
+            ((new (std::get<I>(storage) + index) Fields(std::forward<Args>(args)), ++constructed), ...);
+        }
+        catch (...) {
+            ((I < constructed ? std::destroy_at(std::get<I>(storage) + index) : void()), ...);
+            throw;
+        }
+    }
+
+    template <size_t... I>
+    void ValueConstructRows(size_t first, size_t count, std::index_sequence<I...>) {
+        size_t constructed = 0;
+        try {
+            ((std::uninitialized_value_construct_n(std::get<I>(data_) + first, count), ++constructed), ...);
+        }
+        catch (...) {
+            ((I < constructed ? (void)std::destroy_n(std::get<I>(data_) + first, count) : void()), ...);
+            throw;
+        }
+    }
+
+    template <size_t... I>
+    void DestroyRows(size_t first, size_t last, std::index_sequence<I...>) noexcept {
+        (std::destroy(std::get<I>(data_) + first, std::get<I>(data_) + last), ...);
+    }
+
+    template <size_t... I>
+    void Relocate(Storage& new_data, std::index_sequence<I...>) noexcept {
+        (std::uninitialized_move_n(std::get<I>(data_).GetAddress(), size_, std::get<I>(new_data).GetAddress()), ...);
+        DestroyRows(0, size_, Indices{});
+        (std::get<I>(data_).Swap(std::get<I>(new_data)), ...);
+    }
+
+    template <size_t... I>
+    void ShiftDown(size_t index, std::index_sequence<I...>) noexcept {
+        (std::move(std::get<I>(data_) + index + 1, std::get<I>(data_) + size_, std::get<I>(data_) + index), ...);
+    }
+
+    template <size_t... I>
+    Reference Row(size_t index, std::index_sequence<I...>) noexcept {
+        return Reference(std::get<I>(data_)[index]...);
+    }
+
+    Storage data_;
+    size_t size_ = 0;
+};
@@ -1,37 +1,130 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <new>
 #include <utility>
 #include <memory>
 #include <algorithm>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
+#include <type_traits>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "growth_policy.h"
+#include "vector_stats.h"
+
+// Types whose objects may be moved to a new address with memcpy, leaving the
+// source storage without running its destructor. Specialize for types that are
+// safe to relocate this way but are not trivially copyable.
 template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {
+};
+
+// Allocators may provide T* reallocate(T* p, size_t old_n, size_t new_n),
+// which resizes the block (in place where possible) preserving its bytes.
+// Vector uses it for trivially relocatable T in Reserve, ShrinkToFit and when
+// an append grows the buffer; inserts before the end still relocate into a
+// new block around the gap.
+template <typename Alloc, typename = void>
+struct HasReallocate : std::false_type {
+};
+
+template <typename Alloc>
+struct HasReallocate<Alloc, std::void_t<decltype(std::declval<Alloc&>().reallocate(
+    std::declval<typename std::allocator_traits<Alloc>::pointer>(), size_t{}, size_t{}))>> : std::true_type {
+};
+
+// Selects constructors and Resize overloads that default-initialize elements,
+// leaving trivial types with indeterminate values instead of zeroing them.
+struct DefaultInitTag {
+    explicit DefaultInitTag() = default;
+};
+
+inline constexpr DefaultInitTag kDefaultInit{};
+
+// Carries out Vector's whole-range element operations: building new vectors,
+// copying, relocating on growth and destroying. Each operation is all or
+// nothing: if it throws, the elements it constructed are destroyed again.
+// ParallelBulk in parallel.h spreads them over a thread pool.
+struct SerialBulk {
+    template <typename T>
+    static void ValueConstruct(T* first, size_t count) {
+        std::uninitialized_value_construct_n(first, count);
+    }
+
+    template <typename T>
+    static void DefaultConstruct(T* first, size_t count) {
+        std::uninitialized_default_construct_n(first, count);
+    }
+
+    template <typename T>
+    static void Copy(const T* from, size_t count, T* to) {
+        std::uninitialized_copy_n(from, count, to);
+    }
+
+    template <typename T>
+    static void Move(T* from, size_t count, T* to) {
+        std::uninitialized_move_n(from, count, to);
+    }
+
+    // memcpy of count elements, for trivially relocatable types.
+    template <typename T>
+    static void CopyBytes(const T* from, size_t count, T* to) noexcept {
+        if (count != 0) {
+            std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+        }
+    }
+
+    template <typename T>
+    static void Destroy(T* first, size_t count) noexcept {
+        std::destroy_n(first, count);
+    }
+};
+
+template <typename T, typename Alloc = std::allocator<T>>
 class RawMemory {
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+    static_assert(std::is_same_v<typename AllocTraits::value_type, T>, "Alloc::value_type must be T");
+    static_assert(std::is_same_v<typename AllocTraits::pointer, T*>, "fancy pointers are not supported");
+
 public:
+    using allocator_type = Alloc;
+
     RawMemory() = default;
 
+    explicit RawMemory(const Alloc& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
     RawMemory(const RawMemory&) = delete;
     RawMemory& operator=(const RawMemory& rhs) = delete;
-    RawMemory(RawMemory&& other) noexcept {
-        buffer_ = std::move(other.buffer_);
-        capacity_ = std::move(other.capacity_);
+    RawMemory(RawMemory&& other) noexcept
+        : alloc_(std::move(other.alloc_))
+        , buffer_(std::exchange(other.buffer_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0)) {
     }
     RawMemory& operator=(RawMemory&& rhs) noexcept {
-        std::swap(capacity_, rhs.capacity_);
-        std::swap(buffer_, rhs.buffer_);
+        Swap(rhs);
+        SwapAllocator(rhs);
         return *this;
     }
 
-    explicit RawMemory(size_t capacity)
-        : buffer_(Allocate(capacity))
+    explicit RawMemory(size_t capacity, const Alloc& alloc = Alloc())
+        : alloc_(alloc)
+        , buffer_(Allocate(capacity))
         , capacity_(capacity) {
     }
 
     ~RawMemory() {
-        Deallocate(buffer_);
+        Deallocate(buffer_, capacity_);
     }
 
     T* operator+(size_t offset) noexcept {
@@ -52,11 +145,17 @@ public:
         return buffer_[index];
     }
 
+    // Swaps only the buffers; both sides must use equal allocators.
     void Swap(RawMemory& other) noexcept {
         std::swap(buffer_, other.buffer_);
         std::swap(capacity_, other.capacity_);
     }
 
+    void SwapAllocator(RawMemory& other) noexcept {
+        using std::swap;
+        swap(alloc_, other.alloc_);
+    }
+
     const T* GetAddress() const noexcept {
         return buffer_;
     }
@@ -69,46 +168,154 @@ public:
         return capacity_;
     }
 
+    // Bytes are preserved but may move, so T must be trivially relocatable.
+    void Reallocate(size_t new_capacity) {
+        static_assert(HasReallocate<Alloc>::value && IsTriviallyRelocatable<T>::value);
+        vector_stats::OnAllocate(new_capacity * sizeof(T));
+        buffer_ = alloc_.reallocate(buffer_, capacity_, new_capacity);
+        capacity_ = new_capacity;
+    }
+
+    const Alloc& GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    Alloc& GetAllocator() noexcept {
+        return alloc_;
+    }
+
 private:
     
-    static T* Allocate(size_t n) {
-        return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+    T* Allocate(size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        vector_stats::OnAllocate(n * sizeof(T));
+        return AllocTraits::allocate(alloc_, n);
     }
     
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    void Deallocate(T* buf, size_t n) noexcept {
+        if (buf != nullptr) {
+            AllocTraits::deallocate(alloc_, buf, n);
+        }
     }
 
+    Alloc alloc_;
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
 };
 
+namespace vector_detail {
+
+// Whether an element can be inserted or erased in the middle of a buffer
+// with nothing but the new element's constructor able to throw. Trivially
+// relocatable types qualify whatever their move constructor says, since
+// they are shifted by their bytes.
 template <typename T>
+inline constexpr bool kShiftsInPlace = IsTriviallyRelocatable<T>::value || std::is_nothrow_move_constructible_v<T>;
+
+// Shifts the elements [offset, size) of data one slot right and constructs an
+// element from args at offset < size; data must have room for size + 1. The
+// element is built first, since args may refer to an element that is about to
+// move, so if its constructor throws nothing has changed.
+template <typename T, typename... Args>
+void ShiftInsert(T* data, size_t size, size_t offset, Args&&... args) {
+    static_assert(kShiftsInPlace<T>);
+    if constexpr (IsTriviallyRelocatable<T>::value) {
+        // The new element is relocated into its slot by its bytes, so it is
+        // built in raw storage and never destroyed here.
+        alignas(T) unsigned char value[sizeof(T)];
+        new (value) T(std::forward<Args>(args)...);
+        std::memmove(static_cast<void*>(data + offset + 1), static_cast<const void*>(data + offset),
+                     (size - offset) * sizeof(T));
+        std::memcpy(static_cast<void*>(data + offset), value, sizeof(T));
+    }
+    else {
+        T value(std::forward<Args>(args)...);
+        // Nothing below can throw.
+        if constexpr (std::is_nothrow_move_assignable_v<T>) {
+            new (data + size) T(std::move(data[size - 1]));
+            std::move_backward(data + offset, data + size - 1, data + size);
+            data[offset] = std::move(value);
+        }
+        else {
+            for (size_t i = size; i > offset; --i) {
+                new (data + i) T(std::move(data[i - 1]));
+                std::destroy_at(data + i - 1);
+            }
+            new (data + offset) T(std::move(value));
+        }
+    }
+}
+
+// Removes [offset, offset + count) from the size elements of data, moving the
+// tail down.
+template <typename T>
+void ShiftErase(T* data, size_t size, size_t offset, size_t count) {
+    if constexpr (IsTriviallyRelocatable<T>::value) {
+        std::destroy_n(data + offset, count);
+        std::memmove(static_cast<void*>(data + offset), static_cast<const void*>(data + offset + count),
+                     (size - offset - count) * sizeof(T));
+    }
+    else if constexpr (std::is_nothrow_move_constructible_v<T> && !std::is_move_assignable_v<T>) {
+        std::destroy_n(data + offset, count);
+        for (size_t i = offset; i + count < size; ++i) {
+            new (data + i) T(std::move(data[i + count]));
+            std::destroy_at(data + i + count);
+        }
+    }
+    else {
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            std::move(data + offset + count, data + size, data + offset);
+        }
+        else {
+            std::copy(data + offset + count, data + size, data + offset);
+        }
+        std::destroy_n(data + size - count, count);
+    }
+}
+
+}  // namespace vector_detail
+
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth, typename Bulk = SerialBulk>
 class Vector {
+    using AllocTraits = std::allocator_traits<Alloc>;
+
 public:
     using iterator = T*;
     using const_iterator = const T*;
+    using allocator_type = Alloc;
 
     Vector() = default;
 
-    explicit Vector(size_t size)
-        : data_(size)
+    explicit Vector(const Alloc& alloc) noexcept
+        : data_(alloc) {
+    }
+
+    explicit Vector(size_t size, const Alloc& alloc = Alloc())
+        : data_(size, alloc)
+        , size_(size)  //
+    {
+        Bulk::ValueConstruct(data_.GetAddress(), size);
+    }
+
+    Vector(size_t size, DefaultInitTag, const Alloc& alloc = Alloc())
+        : data_(size, alloc)
         , size_(size)  //
     {
-        std::uninitialized_value_construct_n(data_.GetAddress(), size);
+        Bulk::DefaultConstruct(data_.GetAddress(), size);
     }
 
     explicit Vector(const Vector& other)
-        : data_(other.size_)
+        : data_(other.size_, AllocTraits::select_on_container_copy_construction(other.data_.GetAllocator()))
         , size_(other.size_)
     {
-        std::uninitialized_copy_n(other.data_.GetAddress(), other.size_, data_.GetAddress());
+        Bulk::Copy(other.data_.GetAddress(), other.size_, data_.GetAddress());
     }
 
-    Vector(Vector&& other) noexcept {
-        data_ = std::move(other.data_);
-        size_ = std::move(other.size_);
-        other.size_ = 0;
+    Vector(Vector&& other) noexcept
+        : data_(std::move(other.data_))
+        , size_(std::exchange(other.size_, 0)) {
     }
 
     iterator begin() noexcept {
@@ -139,38 +346,30 @@ public:
                 new (data_ + offset) T(std::forward<Args>(args)...);
             }
             else {
-                auto temp_element = T(std::forward<Args>(args)...);
-
-                new (data_ + size_) T(std::forward<T>(data_[size_ - 1]));
-                std::move_backward((begin() + offset), end() - 1, &data_[size_]);
-
-                data_[offset] = std::forward<T>(temp_element);
+                EmplaceShifting(offset, std::forward<Args>(args)...);
             }
         }
         else {
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-
-            new (new_data + offset) T(std::forward<Args>(args)...);
-
-            try {
-                CopyData(begin(), offset, new_data.GetAddress());
-            }
-            catch (...) {
-                std::destroy_at(new_data + offset);
-                throw;
+            if constexpr (IsTriviallyRelocatable<T>::value && HasReallocate<Alloc>::value) {
+                if (offset == size_) {
+                    // Appends can let the allocator grow the block in place. The
+                    // value is built first, since args may refer to an element.
+                    T value(std::forward<Args>(args)...);
+                    Reallocate(Growth::NextCapacity(data_.Capacity(), sizeof(T)));
+                    new (data_ + offset) T(std::move(value));
+                    size_++;
+                    return &data_[offset];
+                }
             }
 
-            try {
-                CopyData((begin() + offset), (size_ - offset), (new_data.GetAddress() + offset + 1));
-            }
-            catch (...) {
-                std::destroy_n(new_data.GetAddress(), offset + 1);
-                throw;
-            }
+            RawMemory<T, Alloc> new_data(Growth::NextCapacity(data_.Capacity(), sizeof(T)), data_.GetAllocator());
 
-            std::destroy_n(data_.GetAddress(), size_);
-            data_.Swap(new_data);
+            new (new_data + offset) T(std::forward<Args>(args)...);
 
+            if (size_ != 0) {
+                vector_stats::OnReallocate();
+            }
+            RelocateAroundGap(new_data, offset, 1);
         }
 
         size_++;
@@ -178,17 +377,46 @@ public:
     }
 
     iterator Erase(const_iterator pos) {
-        pos->~T();
+        return Erase(pos, pos + 1);
+    }
 
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::move(&data_[(pos - begin() + 1)], end(), &data_[(pos - begin())]);
-        }
-        else {
-            std::copy((pos + 1), cend(), &data_[(pos - begin())]);
+    iterator Erase(const_iterator first, const_iterator last) {
+        size_t offset = (first - cbegin());
+        size_t count = (last - first);
+
+        if (count != 0) {
+            if (offset + count != size_) {
+                vector_stats::OnShift(size_ - offset - count);
+            }
+            vector_detail::ShiftErase(data_.GetAddress(), size_, offset, count);
+            size_ -= count;
+            MaybeShrink();
         }
+        return begin() + offset;
+    }
 
-        size_--;
-        return &data_[(pos - begin())];
+    // O(1) removal that doesn't keep the order: the last element fills the hole.
+    iterator EraseUnordered(const_iterator pos) {
+        size_t offset = (pos - cbegin());
+        assert(offset < size_);
+        if (offset != size_ - 1) {
+            data_[offset] = std::move(data_[size_ - 1]);
+        }
+        PopBack();
+        return begin() + offset;
+    }
+
+    // Unordered removal of several elements; indices must be strictly increasing.
+    // Going from the back means the element filling a hole is never one still
+    // to be removed.
+    template <typename IndexRange>
+    void EraseUnorderedIndices(const IndexRange& sorted_indices) {
+        size_t previous = size_;
+        for (auto it = std::rbegin(sorted_indices); it != std::rend(sorted_indices); ++it) {
+            assert(static_cast<size_t>(*it) < previous);
+            previous = static_cast<size_t>(*it);
+            EraseUnordered(cbegin() + previous);
+        }
     }
 
     iterator Insert(const_iterator pos, const T& value) {
@@ -199,17 +427,106 @@ public:
         return Emplace(pos, std::move(value));
     }
 
+    iterator Insert(const_iterator pos, size_t count, const T& value) {
+        // value may live in this vector, so take a copy before shifting.
+        T value_copy(value);
+        return InsertGap(pos, count,
+            [&value_copy](size_t, size_t n, iterator to) {
+                std::uninitialized_fill_n(to, n, value_copy);
+            },
+            [&value_copy](size_t, size_t n, iterator to) {
+                std::fill_n(to, n, value_copy);
+            });
+    }
+
+    // Unlike with std::vector, [first, last) may be part of this vector when
+    // it is a pointer range; other iterators into it are not detected.
+    template <typename InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    iterator Insert(const_iterator pos, InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+        if constexpr (std::is_convertible_v<InputIt, const T*>) {
+            const T* source = first;
+            if (first != last && std::less_equal<const T*>()(cbegin(), source) && std::less<const T*>()(source, cend())) {
+                // The shift would move the source under the copy, so copy it aside first.
+                Vector aside(data_.GetAllocator());
+                aside.AppendRange(first, last);
+                return Insert(pos, std::make_move_iterator(aside.begin()), std::make_move_iterator(aside.end()));
+            }
+        }
+
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            return InsertGap(pos, static_cast<size_t>(std::distance(first, last)),
+                [first](size_t from, size_t n, iterator to) {
+                    std::uninitialized_copy_n(std::next(first, from), n, to);
+                },
+                [first](size_t from, size_t n, iterator to) {
+                    std::copy_n(std::next(first, from), n, to);
+                });
+        }
+        else {
+            // Single-pass input: append everything, then rotate it into place.
+            size_t offset = (pos - cbegin());
+            size_t old_size = size_;
+            for (; first != last; ++first) {
+                EmplaceBack(*first);
+            }
+            std::rotate((begin() + offset), (begin() + old_size), end());
+            return begin() + offset;
+        }
+    }
+
+    iterator Insert(const_iterator pos, std::initializer_list<T> values) {
+        return Insert(pos, values.begin(), values.end());
+    }
+
+    template <typename InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void AppendRange(InputIt first, InputIt last) {
+        Insert(cend(), first, last);
+    }
+
+    template <typename Range>
+    void AppendRange(const Range& range) {
+        Insert(cend(), std::begin(range), std::end(range));
+    }
+
     void Resize(size_t new_size) {
         if (new_size != size_) {
             if (new_size < size_) {
-                std::destroy_n(data_.GetAddress() + new_size, size_ - new_size);
+                Bulk::Destroy(data_.GetAddress() + new_size, size_ - new_size);
+                size_ = new_size;
+                MaybeShrink();
             }
             else {
                 Reserve(new_size);
-                std::uninitialized_value_construct_n(data_.GetAddress() + size_, (new_size - size_));
+                Bulk::ValueConstruct(data_.GetAddress() + size_, (new_size - size_));
+                size_ = new_size;
             }
+        }
+    }
+
+    // Like Resize, but new elements are default-initialized, so trivial types
+    // are left for the caller to overwrite.
+    void ResizeForOverwrite(size_t new_size) {
+        if (new_size < size_) {
+            Bulk::Destroy(data_.GetAddress() + new_size, size_ - new_size);
             size_ = new_size;
+            MaybeShrink();
         }
+        else if (new_size > size_) {
+            Reserve(new_size);
+            Bulk::DefaultConstruct(data_.GetAddress() + size_, (new_size - size_));
+            size_ = new_size;
+        }
+    }
+
+    // Appends count default-initialized elements and returns the first of them;
+    // [result, result + count) is the range to fill.
+    iterator AppendUninitialized(size_t count) {
+        GrowFor(count);
+        std::uninitialized_default_construct_n(end(), count);
+        size_ += count;
+        return end() - count;
     }
 
     void PushBack(const T& value) {
@@ -229,13 +546,26 @@ public:
     void PopBack() noexcept {
         std::destroy_at(data_.GetAddress() + size_ - 1);
         size_--;
+        MaybeShrink();
     }
 
     Vector& operator=(const Vector& rhs) {
         if (this != &rhs) {
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+                if (data_.GetAllocator() != rhs.data_.GetAllocator()) {
+                    // Memory owned by the old allocator must be released through it.
+                    std::destroy_n(data_.GetAddress(), size_);
+                    size_ = 0;
+                    data_ = RawMemory<T, Alloc>(rhs.data_.GetAllocator());
+                }
+                data_.GetAllocator() = rhs.data_.GetAllocator();
+            }
+
             if (rhs.size_ > data_.Capacity()) {
-                Vector rhs_copy(rhs);
-                Swap(rhs_copy);
+                RawMemory<T, Alloc> new_data(rhs.size_, data_.GetAllocator());
+                Bulk::Copy(rhs.data_.GetAddress(), rhs.size_, new_data.GetAddress());
+                Bulk::Destroy(data_.GetAddress(), size_);
+                data_.Swap(new_data);
             }
             else {
                 std::copy_n(rhs.data_.GetAddress(), std::min(rhs.size_,size_), data_.GetAddress());
@@ -243,29 +573,52 @@ public:
                     std::destroy_n(data_.GetAddress() + rhs.size_, size_ - rhs.size_);
                 }
                 else {
-                    std::uninitialized_copy_n(rhs.data_.GetAddress() + size_, rhs.size_ - size_, data_.GetAddress());
+                    std::uninitialized_copy_n(rhs.data_.GetAddress() + size_, rhs.size_ - size_, data_.GetAddress() + size_);
                 }
-
-                this->size_ = rhs.size_;
             }
+
+            this->size_ = rhs.size_;
         }
         return *this;
     }
 
-    Vector& operator=(Vector&& rhs) noexcept {
-        this->data_ = std::move(rhs.data_);
-        this->size_ = std::move(rhs.size_);
-        rhs.size_ = 0;
+    Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                             || AllocTraits::is_always_equal::value) {
+        if (this != &rhs) {
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                std::destroy_n(data_.GetAddress(), size_);
+                data_ = std::move(rhs.data_);
+            }
+            else if (data_.GetAllocator() == rhs.data_.GetAllocator()) {
+                std::destroy_n(data_.GetAddress(), size_);
+                data_.Swap(rhs.data_);
+            }
+            else {
+                // Unequal, non-propagating allocators: the buffer can't change hands.
+                RawMemory<T, Alloc> new_data(rhs.size_, data_.GetAllocator());
+                std::uninitialized_move_n(rhs.data_.GetAddress(), rhs.size_, new_data.GetAddress());
+                std::destroy_n(data_.GetAddress(), size_);
+                std::destroy_n(rhs.data_.GetAddress(), rhs.size_);
+                data_.Swap(new_data);
+            }
+            this->size_ = std::exchange(rhs.size_, 0);
+        }
         return *this;
     }
 
     void Swap(Vector& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            data_.SwapAllocator(other.data_);
+        }
+        else {
+            assert(data_.GetAllocator() == other.data_.GetAllocator());
+        }
         data_.Swap(other.data_);
         std::swap(size_, other.size_);
     }
 
     ~Vector() {
-        std::destroy_n(data_.GetAddress(), size_);
+        Bulk::Destroy(data_.GetAddress(), size_);
     }
 
     void Reserve(size_t new_capacity) {
@@ -273,12 +626,19 @@ public:
             return;
         }
 
-        RawMemory<T> new_data(new_capacity);
-        CopyData(data_.GetAddress(), size_, new_data.GetAddress());
+        Reallocate(new_capacity);
+    }
 
-        std::destroy_n(data_.GetAddress(), size_);
+    void ShrinkToFit() {
+        if (size_ < data_.Capacity()) {
+            Reallocate(size_);
+        }
+    }
 
-        data_.Swap(new_data);
+    void Clear() noexcept {
+        Bulk::Destroy(data_.GetAddress(), size_);
+        size_ = 0;
+        MaybeShrink();
     }
 
     size_t Size() const noexcept {
@@ -289,6 +649,10 @@ public:
         return data_.Capacity();
     }
 
+    Alloc GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
     const T& operator[](size_t index) const noexcept {
         return const_cast<Vector&>(*this)[index];
     }
@@ -299,15 +663,278 @@ public:
     }
 
 private:
+    // Inserts count elements at pos with one reallocation or one shift of the
+    // tail. construct(from, n, to) builds source elements [from, from + n) in
+    // uninitialized storage at to; assign(from, n, to) assigns them over live ones.
+    template <typename Construct, typename Assign>
+    iterator InsertGap(const_iterator pos, size_t count, Construct construct, Assign assign) {
+        size_t offset = (pos - cbegin());
+        if (count == 0) {
+            return begin() + offset;
+        }
+
+        if (size_ + count > data_.Capacity()) {
+            RawMemory<T, Alloc> new_data(std::max(size_ + count, Growth::NextCapacity(data_.Capacity(), sizeof(T))),
+                                         data_.GetAllocator());
+            construct(0, count, new_data + offset);
+            if (size_ != 0) {
+                vector_stats::OnReallocate();
+            }
+            RelocateAroundGap(new_data, offset, count);
+            size_ += count;
+            return begin() + offset;
+        }
+
+        if (offset != size_) {
+            vector_stats::OnShift(size_ - offset);
+        }
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memmove(static_cast<void*>(begin() + offset + count), static_cast<const void*>(begin() + offset),
+                         (size_ - offset) * sizeof(T));
+            assign(0, count, begin() + offset);
+            size_ += count;
+        }
+        else {
+            size_t elems_after = size_ - offset;
+            iterator old_end = end();
+            if (elems_after > count) {
+                CopyData(old_end - count, count, old_end);
+                size_ += count;
+                std::move_backward((begin() + offset), old_end - count, old_end);
+                assign(0, count, begin() + offset);
+            }
+            else {
+                size_t extra = count - elems_after;
+                construct(elems_after, extra, old_end);
+                try {
+                    CopyData((begin() + offset), elems_after, old_end + extra);
+                }
+                catch (...) {
+                    std::destroy_n(old_end, extra);
+                    throw;
+                }
+                size_ += count;
+                assign(0, elems_after, begin() + offset);
+            }
+        }
+        return begin() + offset;
+    }
+
+    // Constructs an element at offset < size_ in a buffer with room for it. If
+    // anything throws, the vector is left unchanged.
+    template <typename... Args>
+    void EmplaceShifting(size_t offset, Args&&... args) {
+        vector_stats::OnShift(size_ - offset);
+
+        if constexpr (vector_detail::kShiftsInPlace<T>) {
+            vector_detail::ShiftInsert(data_.GetAddress(), size_, offset, std::forward<Args>(args)...);
+        }
+        else {
+            // A throwing move or copy could fail halfway through an in-place
+            // shift, leaving elements neither here nor there, so the result is
+            // built in a second buffer of the same size and swapped in. That
+            // keeps the strong guarantee at the price of allocating Capacity()
+            // elements and copying all size_ of them on every such insert; mark
+            // the type IsTriviallyRelocatable or give it a noexcept move to
+            // shift in place instead. Only the shift is reported: the capacity
+            // doesn't change.
+            RawMemory<T, Alloc> new_data(data_.Capacity(), data_.GetAllocator());
+            new (new_data + offset) T(std::forward<Args>(args)...);
+            RelocateAroundGap(new_data, offset, 1);
+        }
+    }
+
+    // Moves the elements into new_data, leaving the count elements already
+    // constructed at offset in place, and adopts it. The gap is destroyed on failure.
+    void RelocateAroundGap(RawMemory<T, Alloc>& new_data, size_t offset, size_t count) {
+        if constexpr (IsTriviallyRelocatable<T>::value) {
+            RelocateData(begin(), offset, new_data.GetAddress());
+            RelocateData((begin() + offset), (size_ - offset), (new_data.GetAddress() + offset + count));
+        }
+        else {
+            try {
+                CopyData(begin(), offset, new_data.GetAddress());
+            }
+            catch (...) {
+                std::destroy_n(new_data + offset, count);
+                throw;
+            }
+
+            try {
+                CopyData((begin() + offset), (size_ - offset), (new_data.GetAddress() + offset + count));
+            }
+            catch (...) {
+                std::destroy_n(new_data.GetAddress(), offset + count);
+                throw;
+            }
+
+            std::destroy_n(data_.GetAddress(), size_);
+        }
+        data_.Swap(new_data);
+    }
+
+    // Moves the elements to a buffer of new_capacity >= size_ elements.
+    void Reallocate(size_t new_capacity) {
+        if (size_ != 0) {
+            vector_stats::OnReallocate();
+        }
+        if constexpr (IsTriviallyRelocatable<T>::value && HasReallocate<Alloc>::value) {
+            if (data_.GetAddress() != nullptr && new_capacity != 0) {
+                data_.Reallocate(new_capacity);
+                return;
+            }
+        }
+
+        RawMemory<T, Alloc> new_data(new_capacity, data_.GetAllocator());
+        RelocateData(data_.GetAddress(), size_, new_data.GetAddress());
+
+        data_.Swap(new_data);
+    }
+
+    // Gives memory back after removals when the Growth policy asks for it.
+    void MaybeShrink() noexcept {
+        if constexpr (HasShrinkCapacity<Growth>::value) {
+            size_t new_capacity = Growth::ShrinkCapacity(size_, data_.Capacity(), sizeof(T));
+            if (new_capacity < data_.Capacity()) {
+                try {
+                    Reallocate(new_capacity);
+                }
+                catch (...) {
+                    // Relocation leaves the elements intact on failure; keep the larger buffer.
+                }
+            }
+        }
+    }
+
+    // Makes room for count more elements, growing by the policy so that
+    // repeated appends stay amortized.
+    void GrowFor(size_t count) {
+        if (size_ + count > data_.Capacity()) {
+            Reserve(std::max(size_ + count, Growth::NextCapacity(data_.Capacity(), sizeof(T))));
+        }
+    }
+
     void CopyData(iterator from, size_t count, iterator to) {
         if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(from, count, to);
+            vector_stats::OnMove(count);
+            Bulk::Move(from, count, to);
+        }
+        else {
+            vector_stats::OnCopy(count);
+            Bulk::Copy(from, count, to);
+        }
+    }
+
+    // Moves count elements to uninitialized storage and ends the lifetime of the sources.
+    void RelocateData(iterator from, size_t count, iterator to) {
+        if constexpr (IsTriviallyRelocatable<T>::value) {
+            vector_stats::OnMove(count);
+            Bulk::CopyBytes(from, count, to);
         }
         else {
-            std::uninitialized_copy_n(from, count, to);
+            CopyData(from, count, to);
+            Bulk::Destroy(from, count);
         }
     }
 
-    RawMemory<T> data_;
+    RawMemory<T, Alloc> data_;
     size_t size_ = 0;
 };
+
+#if defined(__AVX2__)
+namespace vector_detail {
+
+// Row m lists the 32-bit lanes whose bit is set in m, in order, for
+// _mm256_permutevar8x32_epi32; the remaining entries are don't-cares.
+struct CompressTable {
+    alignas(32) uint32_t lanes[256][8];
+};
+
+constexpr CompressTable MakeCompressTable() {
+    CompressTable table{};
+    for (uint32_t mask = 0; mask < 256; ++mask) {
+        uint32_t out = 0;
+        for (uint32_t lane = 0; lane < 8; ++lane) {
+            if (mask >> lane & 1) {
+                table.lanes[mask][out++] = lane;
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr CompressTable kCompressTable = MakeCompressTable();
+
+// Moves the elements of [first, last) failing pred to the front, keeping
+// their order, and returns the new end. Only the compaction is vectorized:
+// pred is still called once per element, in order, as by std::remove_if, and
+// its results for a 32-byte block form a keep mask. The survivors are then
+// packed with one permute and one unaligned store, which stays inside the
+// block just read, so unread input is never overwritten.
+template <typename T, typename Predicate>
+T* CompactAvx2(T* first, T* last, Predicate& pred) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+    constexpr size_t kLanes = 32 / sizeof(T);
+
+    T* out = first;
+    T* it = first;
+    for (; static_cast<size_t>(last - it) >= kLanes; it += kLanes) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+        uint32_t keep = 0;
+        size_t kept = 0;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            bool survives = !static_cast<bool>(pred(it[lane]));
+            keep |= static_cast<uint32_t>(survives) << lane;
+            kept += survives;
+        }
+        uint32_t keep32 = keep;
+        if constexpr (sizeof(T) == 8) {
+            // Each 64-bit lane is a pair of 32-bit ones.
+            keep32 = (keep & 1) * 3 | (keep & 2) * 6 | (keep & 4) * 12 | (keep & 8) * 24;
+        }
+        __m256i indices = _mm256_load_si256(reinterpret_cast<const __m256i*>(kCompressTable.lanes[keep32]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(block, indices));
+        out += kept;
+    }
+    for (; it != last; ++it) {
+        if (!pred(*it)) {
+            *out++ = *it;
+        }
+    }
+    return out;
+}
+
+}  // namespace vector_detail
+#endif
+
+// Removes the elements satisfying pred in one compaction pass and returns
+// how many were removed. With AVX2, arithmetic T of 4 or 8 bytes and a
+// trivially copyable pred are compacted a 32-byte block at a time; pred itself
+// is evaluated with scalar code.
+template <typename T, typename Alloc, typename Growth, typename Bulk, typename Predicate>
+size_t EraseIf(Vector<T, Alloc, Growth, Bulk>& vector, Predicate pred) {
+    typename Vector<T, Alloc, Growth, Bulk>::iterator new_end;
+
+#if defined(__AVX2__)
+    if constexpr (std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)
+                  && std::is_trivially_copyable_v<Predicate>) {
+        new_end = vector_detail::CompactAvx2(vector.begin(), vector.end(), pred);
+    }
+    else {
+        new_end = std::remove_if(vector.begin(), vector.end(), pred);
+    }
+#else
+    new_end = std::remove_if(vector.begin(), vector.end(), pred);
+#endif
+
+    size_t removed = (vector.end() - new_end);
+    vector.Erase(new_end, vector.cend());
+    return removed;
+}
+
+template <typename T, typename Alloc, typename Growth, typename Bulk, typename U>
+size_t Erase(Vector<T, Alloc, Growth, Bulk>& vector, const U& value) {
+    return EraseIf(vector, [&value](const T& element) {
+        return element == value;
+    });
+}
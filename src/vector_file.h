@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "vector.h"
+
+// On-disk layout shared by MappedVector files and Serialize: a 64-byte header
+// followed by count elements stored as raw bytes in native byte order. Keeping
+// the header a cache line long leaves the elements aligned for any T up to 64
+// bytes. Readers accept trailing bytes past the elements, which is where a
+// MappedVector keeps its spare capacity.
+struct alignas(64) VectorFileHeader {
+    static constexpr char kMagic[8] = {'S', 'V', 'E', 'C', 'T', 'O', 'R', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t element_size;
+    uint32_t element_alignment;
+    uint32_t reserved;
+    uint64_t count;
+};
+
+static_assert(sizeof(VectorFileHeader) == 64);
+
+template <typename T>
+VectorFileHeader MakeVectorFileHeader(uint64_t count) noexcept {
+    VectorFileHeader header{};
+    std::memcpy(header.magic, VectorFileHeader::kMagic, sizeof(header.magic));
+    header.version = VectorFileHeader::kVersion;
+    header.element_size = sizeof(T);
+    header.element_alignment = alignof(T);
+    header.count = count;
+    return header;
+}
+
+// Throws std::runtime_error unless header describes elements of type T and
+// file_size bytes are enough to hold them.
+template <typename T>
+void CheckVectorFileHeader(const VectorFileHeader& header, uint64_t file_size) {
+    static_assert(alignof(T) <= alignof(VectorFileHeader), "elements would be misaligned after the header");
+
+    if (std::memcmp(header.magic, VectorFileHeader::kMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("not a vector file");
+    }
+    if (header.version != VectorFileHeader::kVersion) {
+        throw std::runtime_error("unsupported vector file version");
+    }
+    if (header.element_size != sizeof(T) || header.element_alignment != alignof(T)) {
+        throw std::runtime_error("vector file element type mismatch");
+    }
+    if ((file_size - sizeof(VectorFileHeader)) / sizeof(T) < header.count) {
+        throw std::runtime_error("vector file is truncated");
+    }
+}
+
+namespace vector_file_detail {
+
+class FileDescriptor {
+public:
+    FileDescriptor(const std::string& path, int flags) {
+        fd_ = open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    ~FileDescriptor() {
+        close(fd_);
+    }
+
+    int Get() const noexcept {
+        return fd_;
+    }
+
+    uint64_t Size() const {
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        }
+        return static_cast<uint64_t>(st.st_size);
+    }
+
+private:
+    int fd_;
+};
+
+// writev that resumes after short writes and EINTR.
+inline void WriteAll(int fd, iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t written = writev(fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "writev");
+        }
+        size_t remaining = static_cast<size_t>(written);
+        while (iovcnt > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+}
+
+inline void ReadAll(int fd, void* buffer, size_t size) {
+    char* out = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t got = read(fd, out, size);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "read");
+        }
+        if (got == 0) {
+            throw std::runtime_error("vector file is truncated");
+        }
+        out += got;
+        size -= static_cast<size_t>(got);
+    }
+}
+
+}  // namespace vector_file_detail
+
+// Writes the header and the elements' bytes with a single writev.
+template <typename T, typename Alloc, typename Growth, typename Bulk>
+void Serialize(const Vector<T, Alloc, Growth, Bulk>& vector, const std::string& path) {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are stored as raw bytes");
+
+    VectorFileHeader header = MakeVectorFileHeader<T>(vector.Size());
+    iovec iov[2] = {
+        {&header, sizeof(header)},
+        {const_cast<T*>(vector.begin()), vector.Size() * sizeof(T)},
+    };
+
+    vector_file_detail::FileDescriptor file(path, O_WRONLY | O_CREAT | O_TRUNC);
+    vector_file_detail::WriteAll(file.Get(), iov, 2);
+}
+
+// Reads a file written by Serialize (or a MappedVector file) into a new Vector.
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth, typename Bulk = SerialBulk>
+Vector<T, Alloc, Growth, Bulk> Deserialize(const std::string& path, const Alloc& alloc = Alloc()) {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are stored as raw bytes");
+
+    vector_file_detail::FileDescriptor file(path, O_RDONLY);
+    uint64_t file_size = file.Size();
+
+    VectorFileHeader header;
+    vector_file_detail::ReadAll(file.Get(), &header, sizeof(header));
+    CheckVectorFileHeader<T>(header, file_size);
+
+    Vector<T, Alloc, Growth, Bulk> vector(static_cast<size_t>(header.count), kDefaultInit, alloc);
+    vector_file_detail::ReadAll(file.Get(), vector.begin(), vector.Size() * sizeof(T));
+    return vector;
+}
+
+// Read-only, zero-copy view of a vector file: the file is mapped and its
+// elements are used in place.
+template <typename T>
+class VectorView {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are stored as raw bytes");
+
+public:
+    using iterator = const T*;
+    using const_iterator = const T*;
+
+    explicit VectorView(const std::string& path) {
+        vector_file_detail::FileDescriptor file(path, O_RDONLY);
+        uint64_t file_size = file.Size();
+        if (file_size < sizeof(VectorFileHeader)) {
+            throw std::runtime_error("not a vector file: " + path);
+        }
+
+        void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file.Get(), 0);
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap " + path);
+        }
+        mapping_ = static_cast<const unsigned char*>(mapping);
+        mapping_size_ = file_size;
+
+        try {
+            CheckVectorFileHeader<T>(*reinterpret_cast<const VectorFileHeader*>(mapping_), file_size);
+        }
+        catch (...) {
+            munmap(mapping, mapping_size_);
+            throw;
+        }
+        size_ = static_cast<size_t>(reinterpret_cast<const VectorFileHeader*>(mapping_)->count);
+    }
+
+    VectorView(const VectorView&) = delete;
+    VectorView& operator=(const VectorView&) = delete;
+
+    VectorView(VectorView&& other) noexcept
+        : mapping_(std::exchange(other.mapping_, nullptr))
+        , mapping_size_(std::exchange(other.mapping_size_, 0))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    VectorView& operator=(VectorView&& rhs) noexcept {
+        std::swap(mapping_, rhs.mapping_);
+        std::swap(mapping_size_, rhs.mapping_size_);
+        std::swap(size_, rhs.size_);
+        return *this;
+    }
+
+    ~VectorView() {
+        if (mapping_ != nullptr) {
+            munmap(const_cast<unsigned char*>(mapping_), mapping_size_);
+        }
+    }
+
+    const_iterator begin() const noexcept {
+        return reinterpret_cast<const T*>(mapping_ + sizeof(VectorFileHeader));
+    }
+    const_iterator end() const noexcept {
+        return begin() + size_;
+    }
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return begin()[index];
+    }
+
+private:
+    const unsigned char* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    size_t size_ = 0;
+};
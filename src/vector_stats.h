@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Opt-in instrumentation of RawMemory and Vector. Build everything with
+// -DVECTOR_STATS to count, per call-site tag:
+//   - allocations and bytes allocated,
+//   - reallocations (a buffer replaced while holding elements),
+//   - elements moved and copied on relocation,
+//   - mid-vector shifts done by Emplace, Insert and Erase,
+//   - the largest buffer allocated.
+//
+// Events are charged to the innermost VectorStatsScope active on the current
+// thread, or to "untagged" outside any scope:
+//
+//     {
+//         VectorStatsScope scope("parser/tokens");
+//         ParseTokens(input, tokens);
+//     }
+//     PrintVectorStats(stderr);
+//
+// Without VECTOR_STATS the hooks are empty inline functions, VectorStatsScope
+// is an empty class and the reporting functions see no tags, so nothing is
+// left in the binary and instrumented code still builds. The macro must be
+// the same in every translation unit.
+
+struct VectorStatsSnapshot {
+    uint64_t allocations = 0;
+    uint64_t bytes_allocated = 0;
+    uint64_t reallocations = 0;
+    uint64_t elements_moved = 0;
+    uint64_t elements_copied = 0;
+    uint64_t shifts = 0;
+    uint64_t elements_shifted = 0;
+    uint64_t peak_capacity_bytes = 0;
+};
+
+#ifdef VECTOR_STATS
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace vector_stats {
+
+struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes_allocated{0};
+    std::atomic<uint64_t> reallocations{0};
+    std::atomic<uint64_t> elements_moved{0};
+    std::atomic<uint64_t> elements_copied{0};
+    std::atomic<uint64_t> shifts{0};
+    std::atomic<uint64_t> elements_shifted{0};
+    std::atomic<uint64_t> peak_capacity_bytes{0};
+};
+
+// Events outside any scope. A constant-initialized global rather than a
+// registry entry, so the noexcept hooks never allocate to find it.
+inline Counters untagged;
+
+// Counters live as long as the program, so scopes can keep raw pointers. The
+// registry is never destroyed, so vectors torn down by static destructors can
+// still report.
+class Registry {
+public:
+    static Registry& Instance() {
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+
+    Counters& Get(const std::string& tag) {
+        std::lock_guard lock(mutex_);
+        Counters*& counters = counters_[tag];
+        if (counters == nullptr) {
+            counters = new Counters();
+        }
+        return *counters;
+    }
+
+    template <typename F>
+    void ForEach(F f) {
+        std::lock_guard lock(mutex_);
+        for (const auto& [tag, counters] : counters_) {
+            f(tag, Snapshot(*counters));
+        }
+    }
+
+    void Reset() {
+        std::lock_guard lock(mutex_);
+        for (const auto& entry : counters_) {
+            Counters& counters = *entry.second;
+            for (auto* counter : {&counters.allocations, &counters.bytes_allocated, &counters.reallocations,
+                                  &counters.elements_moved, &counters.elements_copied, &counters.shifts,
+                                  &counters.elements_shifted, &counters.peak_capacity_bytes}) {
+                counter->store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    Registry() {
+        counters_["untagged"] = &untagged;
+    }
+
+    static VectorStatsSnapshot Snapshot(const Counters& counters) {
+        VectorStatsSnapshot snapshot;
+        snapshot.allocations = counters.allocations.load(std::memory_order_relaxed);
+        snapshot.bytes_allocated = counters.bytes_allocated.load(std::memory_order_relaxed);
+        snapshot.reallocations = counters.reallocations.load(std::memory_order_relaxed);
+        snapshot.elements_moved = counters.elements_moved.load(std::memory_order_relaxed);
+        snapshot.elements_copied = counters.elements_copied.load(std::memory_order_relaxed);
+        snapshot.shifts = counters.shifts.load(std::memory_order_relaxed);
+        snapshot.elements_shifted = counters.elements_shifted.load(std::memory_order_relaxed);
+        snapshot.peak_capacity_bytes = counters.peak_capacity_bytes.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    std::mutex mutex_;
+    std::map<std::string, Counters*> counters_;
+};
+
+inline thread_local Counters* current = nullptr;
+
+inline Counters& Current() noexcept {
+    return current != nullptr ? *current : untagged;
+}
+
+inline void Add(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+inline void OnAllocate(size_t bytes) noexcept {
+    Counters& counters = Current();
+    Add(counters.allocations, 1);
+    Add(counters.bytes_allocated, bytes);
+    uint64_t peak = counters.peak_capacity_bytes.load(std::memory_order_relaxed);
+    while (bytes > peak && !counters.peak_capacity_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+inline void OnReallocate() noexcept {
+    Add(Current().reallocations, 1);
+}
+
+inline void OnMove(size_t count) noexcept {
+    Add(Current().elements_moved, count);
+}
+
+inline void OnCopy(size_t count) noexcept {
+    Add(Current().elements_copied, count);
+}
+
+inline void OnShift(size_t count) noexcept {
+    Counters& counters = Current();
+    Add(counters.shifts, 1);
+    Add(counters.elements_shifted, count);
+}
+
+}  // namespace vector_stats
+
+// Charges the current thread's vector events to tag until destroyed.
+class VectorStatsScope {
+public:
+    explicit VectorStatsScope(const std::string& tag)
+        : previous_(vector_stats::current) {
+        vector_stats::current = &vector_stats::Registry::Instance().Get(tag);
+    }
+
+    VectorStatsScope(const VectorStatsScope&) = delete;
+    VectorStatsScope& operator=(const VectorStatsScope&) = delete;
+
+    ~VectorStatsScope() {
+        vector_stats::current = previous_;
+    }
+
+private:
+    vector_stats::Counters* previous_;
+};
+
+// Calls f(tag, snapshot) for every tag, in tag order.
+template <typename F>
+void ForEachVectorStats(F f) {
+    vector_stats::Registry::Instance().ForEach(f);
+}
+
+inline void ResetVectorStats() {
+    vector_stats::Registry::Instance().Reset();
+}
+
+// One tab-separated line per tag, after a header line.
+inline void PrintVectorStats(std::FILE* out) {
+    std::fprintf(out, "tag\tallocations\tbytes\treallocations\tmoved\tcopied\tshifts\tshifted\tpeak_bytes\n");
+    ForEachVectorStats([out](const std::string& tag, const VectorStatsSnapshot& stats) {
+        std::fprintf(out, "%s\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\n", tag.c_str(),
+                     static_cast<unsigned long long>(stats.allocations),
+                     static_cast<unsigned long long>(stats.bytes_allocated),
+                     static_cast<unsigned long long>(stats.reallocations),
+                     static_cast<unsigned long long>(stats.elements_moved),
+                     static_cast<unsigned long long>(stats.elements_copied),
+                     static_cast<unsigned long long>(stats.shifts),
+                     static_cast<unsigned long long>(stats.elements_shifted),
+                     static_cast<unsigned long long>(stats.peak_capacity_bytes));
+    });
+}
+
+#else
+
+namespace vector_stats {
+
+inline void OnAllocate(size_t) noexcept {
+}
+inline void OnReallocate() noexcept {
+}
+inline void OnMove(size_t) noexcept {
+}
+inline void OnCopy(size_t) noexcept {
+}
+inline void OnShift(size_t) noexcept {
+}
+
+}  // namespace vector_stats
+
+class VectorStatsScope {
+public:
+    template <typename Tag>
+    explicit VectorStatsScope(const Tag&) noexcept {
+    }
+};
+
+template <typename F>
+void ForEachVectorStats(F) {
+}
+
+inline void ResetVectorStats() {
+}
+
+inline void PrintVectorStats(std::FILE*) {
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "allocators.h"
+#include "vector.h"
+
+#include "check.h"
+#include "counting_new.h"
+
+int main() {
+    // A vector growing alone on top of the arena extends in place.
+    {
+        MonotonicArena arena;
+        Vector<int, ArenaAllocator<int>> values{ArenaAllocator<int>(arena)};
+        values.PushBack(0);
+        const int* data = values.begin();
+        for (int i = 1; i < 1000; ++i) {
+            values.PushBack(i);
+        }
+        CHECK(values.begin() == data);
+        for (int i = 0; i < 1000; ++i) {
+            CHECK(values[i] == i);
+        }
+    }
+
+    // Request rounds: once the first round has sized the arena's blocks, later
+    // rounds must not touch the global heap.
+    MonotonicArena arena;
+    for (int round = 0; round < 10; ++round) {
+        size_t before = HeapAllocations();
+        for (int k = 0; k < 16; ++k) {
+            Vector<int, ArenaAllocator<int>> values{ArenaAllocator<int>(arena)};
+            for (int i = 0; i < 10000; ++i) {
+                values.PushBack(i);
+            }
+            CHECK(values[9999] == 9999);
+        }
+
+        // Interleaved growth: neither buffer stays on top, so they move.
+        Vector<double, ArenaAllocator<double>> xs{ArenaAllocator<double>(arena)};
+        Vector<double, ArenaAllocator<double>> ys{ArenaAllocator<double>(arena)};
+        for (int i = 0; i < 5000; ++i) {
+            xs.PushBack(i);
+            ys.PushBack(-i);
+        }
+        CHECK(xs[4999] == 4999 && ys[4999] == -4999);
+
+        arena.Reset();
+        if (round == 0) {
+            CHECK(HeapAllocations() > before);
+        }
+        else {
+            CHECK(HeapAllocations() == before);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "concurrent_vector.h"
+
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+int main() {
+    // Threads racing into each new segment: every element lands exactly once.
+    constexpr size_t kThreads = 8;
+    constexpr size_t kPerThread = 20000;
+    ConcurrentVector<size_t, 4> values;
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&values, t] {
+            for (size_t i = 0; i < kPerThread; ++i) {
+                size_t index = values.PushBack(t * kPerThread + i);
+                CHECK(values[index] == t * kPerThread + i);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    CHECK(values.Size() == kThreads * kPerThread);
+    std::vector<bool> seen(kThreads * kPerThread);
+    values.ForEachPublished([&seen](size_t, size_t value) {
+        CHECK(!seen[value]);
+        seen[value] = true;
+    });
+    for (bool found : seen) {
+        CHECK(found);
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "counting_new.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+size_t heap_allocations = 0;
+
+}  // namespace
+
+size_t HeapAllocations() noexcept {
+    return heap_allocations;
+}
+
+void* operator new(size_t size) {
+    ++heap_allocations;
+    if (void* ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
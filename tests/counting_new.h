@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+// Calls to the global operator new so far. Programs using it link
+// counting_new.cpp, which replaces operator new and delete; keeping them in
+// their own translation unit stops GCC from pairing an inlined delete with a
+// new it can't see and warning about a mismatch.
+size_t HeapAllocations() noexcept;
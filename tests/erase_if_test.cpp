@@ -0,0 +1,74 @@
+#include "vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+// EraseIf must match std::remove_if for every size around the 32-byte blocks
+// and for every survivor pattern within a block.
+template <typename T, typename Predicate>
+void CheckMatchesRemoveIf(Predicate pred) {
+    for (size_t n = 0; n <= 70; ++n) {
+        for (uint32_t seed = 0; seed < 64; ++seed) {
+            Vector<T> values;
+            std::vector<T> expected;
+            uint32_t state = seed * 2654435761u + static_cast<uint32_t>(n);
+            for (size_t i = 0; i < n; ++i) {
+                state = state * 1103515245u + 12345u;
+                T value = static_cast<T>(state >> 16 & 0xff);
+                values.PushBack(value);
+                expected.push_back(value);
+            }
+            expected.erase(std::remove_if(expected.begin(), expected.end(), pred), expected.end());
+
+            size_t removed = EraseIf(values, pred);
+            CHECK(removed == n - expected.size());
+            CHECK(values.Size() == expected.size());
+            CHECK(std::equal(values.begin(), values.end(), expected.begin()));
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    auto odd = [](auto value) {
+        return static_cast<int64_t>(value) % 2 != 0;
+    };
+    auto small = [](auto value) {
+        return value < 100;
+    };
+    auto none = [](auto) {
+        return false;
+    };
+    auto all = [](auto) {
+        return true;
+    };
+
+    CheckMatchesRemoveIf<int>(odd);
+    CheckMatchesRemoveIf<int>(small);
+    CheckMatchesRemoveIf<int>(none);
+    CheckMatchesRemoveIf<int>(all);
+    CheckMatchesRemoveIf<uint32_t>(small);
+    CheckMatchesRemoveIf<float>(small);
+    CheckMatchesRemoveIf<int64_t>(odd);
+    CheckMatchesRemoveIf<double>(small);
+    CheckMatchesRemoveIf<double>(all);
+    CheckMatchesRemoveIf<uint8_t>(odd);
+    CheckMatchesRemoveIf<int16_t>(small);
+    // Not trivially copyable, so never takes the AVX2 path.
+    CheckMatchesRemoveIf<int>(std::function<bool(int)>(small));
+
+    Vector<int> values;
+    for (int value : {1, 2, 3, 2, 5, 2}) {
+        values.PushBack(value);
+    }
+    CHECK(Erase(values, 2) == 3);
+    CHECK(values.Size() == 3 && values[0] == 1 && values[1] == 3 && values[2] == 5);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "incremental_vector.h"
+
+#include <algorithm>
+#include <string>
+
+#include "check.h"
+
+int main() {
+    // Pushing back an element of the range still being migrated: the new copy
+    // must be made before that element moves and its buffer is freed. Each
+    // push migrates the next two elements, so after p pushes since the buffer
+    // grew, element 2p is the next to move.
+    IncrementalVector<std::string> strings;
+    size_t old_size = 0;
+    size_t pushes_since_growth = 0;
+    for (int i = 0; i < 2000; ++i) {
+        size_t capacity = strings.Capacity();
+        size_t source = 2 * pushes_since_growth;
+        if (strings.IsMigrating() && source < old_size) {
+            std::string expected = strings[source];
+            strings.PushBack(strings[source]);
+            CHECK(strings[strings.Size() - 1] == expected);
+        }
+        else {
+            strings.PushBack(std::string(32, static_cast<char>('a' + i % 26)));
+        }
+
+        if (strings.Capacity() != capacity) {
+            old_size = strings.Size() - 1;
+            pushes_since_growth = 1;
+        }
+        else {
+            ++pushes_since_growth;
+        }
+    }
+
+    // Same when the push itself starts a migration.
+    IncrementalVector<std::string> full;
+    full.PushBack(std::string(32, 'x'));
+    while (full.Size() < full.Capacity()) {
+        full.PushBack(full[0]);
+    }
+    full.PushBack(full[0]);
+    CHECK(full[full.Size() - 1] == std::string(32, 'x'));
+
+    for (const std::string& value : full) {
+        CHECK(value == std::string(32, 'x'));
+    }
+
+    // A const vector can be walked mid-migration, and that doesn't finish it.
+    IncrementalVector<int> numbers;
+    for (int i = 0; i < 100; ++i) {
+        numbers.PushBack(i);
+    }
+    while (!numbers.IsMigrating()) {
+        numbers.PushBack(static_cast<int>(numbers.Size()));
+    }
+    const IncrementalVector<int>& view = numbers;
+    int expected = 0;
+    for (int value : view) {
+        CHECK(value == expected++);
+    }
+    CHECK(static_cast<size_t>(expected) == view.Size());
+    CHECK(view.cend() - view.cbegin() == static_cast<std::ptrdiff_t>(view.Size()));
+    CHECK(std::is_sorted(view.begin(), view.end()));
+    CHECK(numbers.IsMigrating());
+    return 0;
+}
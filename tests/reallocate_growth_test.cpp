@@ -0,0 +1,108 @@
+#include "allocators.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "check.h"
+
+namespace {
+
+size_t reallocate_calls = 0;
+
+template <typename T>
+struct CountingReallocator {
+    using value_type = T;
+
+    CountingReallocator() noexcept = default;
+
+    template <typename U>
+    CountingReallocator(const CountingReallocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        ::operator delete(ptr);
+    }
+
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        ++reallocate_calls;
+        T* new_ptr = allocate(new_n);
+        std::memcpy(static_cast<void*>(new_ptr), static_cast<const void*>(ptr), std::min(old_n, new_n) * sizeof(T));
+        deallocate(ptr, old_n);
+        return new_ptr;
+    }
+
+    friend bool operator==(const CountingReallocator&, const CountingReallocator&) noexcept {
+        return true;
+    }
+    friend bool operator!=(const CountingReallocator&, const CountingReallocator&) noexcept {
+        return false;
+    }
+};
+
+size_t realloc_calls = 0;
+
+template <typename T>
+struct CountingMallocAllocator : MallocAllocator<T> {
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        ++realloc_calls;
+        return MallocAllocator<T>::reallocate(ptr, old_n, new_n);
+    }
+};
+
+}  // namespace
+
+int main() {
+    // Every growth after the first allocation goes through reallocate().
+    Vector<int, CountingReallocator<int>> values;
+    size_t growths = 0;
+    for (int i = 0; i < 100000; ++i) {
+        size_t capacity = values.Capacity();
+        values.PushBack(i);
+        if (capacity != 0 && values.Capacity() != capacity) {
+            ++growths;
+        }
+    }
+    CHECK(growths > 0);
+    CHECK(reallocate_calls == growths);
+    for (int i = 0; i < 100000; ++i) {
+        CHECK(values[i] == i);
+    }
+
+    // MallocAllocator's std::realloc is reached the same way.
+    Vector<double, CountingMallocAllocator<double>> doubles;
+    for (int i = 0; i < 100000; ++i) {
+        doubles.EmplaceBack(i * 0.5);
+    }
+    CHECK(realloc_calls > 0);
+    for (int i = 0; i < 100000; ++i) {
+        CHECK(doubles[i] == i * 0.5);
+    }
+
+    // Pushing back an element of the vector itself while it grows.
+    Vector<int, CountingReallocator<int>> aliased;
+    aliased.PushBack(7);
+    for (int i = 0; i < 1000; ++i) {
+        aliased.PushBack(aliased[aliased.Size() - 1]);
+    }
+    for (int value : aliased) {
+        CHECK(value == 7);
+    }
+
+    // Inserts away from the end still shift around a gap.
+    size_t calls = reallocate_calls;
+    Vector<int, CountingReallocator<int>> front;
+    for (int i = 0; i < 100; ++i) {
+        front.Insert(front.begin(), i);
+    }
+    CHECK(reallocate_calls == calls);
+    for (int i = 0; i < 100; ++i) {
+        CHECK(front[i] == 99 - i);
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "segmented_vector.h"
+
+#include <stdexcept>
+
+#include "check.h"
+
+namespace {
+
+int live = 0;
+int copies_left = 0;
+
+struct Tracked {
+    Tracked() {
+        ++live;
+    }
+
+    Tracked(const Tracked&) {
+        if (copies_left-- == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        ++live;
+    }
+
+    ~Tracked() {
+        --live;
+    }
+};
+
+}  // namespace
+
+int main() {
+    // A copy that throws partway destroys the elements already copied.
+    {
+        SegmentedVector<Tracked, 16> source;
+        for (int i = 0; i < 100; ++i) {
+            source.EmplaceBack();
+        }
+        CHECK(live == 100);
+
+        copies_left = 40;
+        bool thrown = false;
+        try {
+            SegmentedVector<Tracked, 16> copy(source);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(live == 100);
+
+        copies_left = 1000;
+        SegmentedVector<Tracked, 16> copy(source);
+        CHECK(copy.Size() == 100);
+        CHECK(live == 200);
+    }
+    CHECK(live == 0);
+    return 0;
+}
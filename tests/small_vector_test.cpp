@@ -0,0 +1,173 @@
+#include "small_vector.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "allocators.h"
+#include "check.h"
+
+namespace {
+
+// Remembers which allocator id owns each block, so a block freed through the
+// wrong allocator is caught.
+std::map<void*, int> owners;
+
+template <typename T>
+struct TaggedAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit TaggedAllocator(int id) noexcept
+        : id(id) {
+    }
+
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U>& other) noexcept
+        : id(other.id) {
+    }
+
+    T* allocate(size_t n) {
+        T* ptr = std::allocator<T>().allocate(n);
+        owners[ptr] = id;
+        return ptr;
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        CHECK(owners.at(ptr) == id);
+        owners.erase(ptr);
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    friend bool operator==(const TaggedAllocator& lhs, const TaggedAllocator& rhs) noexcept {
+        return lhs.id == rhs.id;
+    }
+    friend bool operator!=(const TaggedAllocator& lhs, const TaggedAllocator& rhs) noexcept {
+        return lhs.id != rhs.id;
+    }
+
+    int id;
+};
+
+// Its move may throw, so middle inserts can't shift in place.
+struct ThrowingMove {
+    explicit ThrowingMove(int i)
+        : value(std::to_string(i)) {
+    }
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&& other) noexcept(false)
+        : value(std::move(other.value)) {
+    }
+    ThrowingMove& operator=(const ThrowingMove&) = default;
+    ThrowingMove& operator=(ThrowingMove&&) = default;
+
+    std::string value;
+};
+
+// Nothrow-movable but not assignable.
+struct NonAssignable {
+    explicit NonAssignable(int i)
+        : value(std::make_unique<int>(i)) {
+    }
+    NonAssignable(NonAssignable&&) noexcept = default;
+    NonAssignable& operator=(NonAssignable&&) = delete;
+
+    std::unique_ptr<int> value;
+};
+
+template <typename V>
+void Fill(V& values, int count, int first = 0) {
+    for (int i = 0; i < count; ++i) {
+        values.EmplaceBack(first + i);
+    }
+}
+
+int Value(int value) {
+    return value;
+}
+int Value(const ThrowingMove& value) {
+    return std::stoi(value.value);
+}
+int Value(const NonAssignable& value) {
+    return *value.value;
+}
+
+// Inserts in the middle and erases again, inline and on the heap.
+template <typename T>
+void CheckMiddleInsertAndErase() {
+    for (int count : {3, 20}) {
+        SmallVector<T, 4> values;
+        Fill(values, count);
+        values.Emplace(values.begin() + 1, 100);
+        CHECK(values.Size() == static_cast<size_t>(count) + 1);
+        CHECK(Value(values[0]) == 0 && Value(values[1]) == 100 && Value(values[2]) == 1);
+        CHECK(Value(values[count]) == count - 1);
+
+        values.Erase(values.begin() + 1);
+        values.Erase(values.begin(), values.begin() + 2);
+        CHECK(values.Size() == static_cast<size_t>(count) - 2);
+        for (int i = 0; i < count - 2; ++i) {
+            CHECK(Value(values[i]) == i + 2);
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    CheckMiddleInsertAndErase<int>();
+    CheckMiddleInsertAndErase<ThrowingMove>();
+    CheckMiddleInsertAndErase<NonAssignable>();
+
+    // Non-propagating, unequal allocators: a move assignment can't take the
+    // buffer, and the target stays bound to its own arena.
+    {
+        MonotonicArena first_arena;
+        MonotonicArena second_arena;
+        using Small = SmallVector<int, 4, ArenaAllocator<int>>;
+        Small first{ArenaAllocator<int>(first_arena)};
+        Small second{ArenaAllocator<int>(second_arena)};
+        Fill(second, 100);
+        first = std::move(second);
+        CHECK(first.GetAllocator().GetArena() == &first_arena);
+        CHECK(first.Size() == 100 && first[99] == 99);
+
+        Small copy{ArenaAllocator<int>(second_arena)};
+        copy = first;
+        CHECK(copy.GetAllocator().GetArena() == &second_arena);
+        CHECK(copy.Size() == 100 && copy[42] == 42);
+    }
+
+    // Propagating allocators follow the buffers; TaggedAllocator checks every
+    // block is freed by the allocator that allocated it.
+    {
+        using Small = SmallVector<int, 4, TaggedAllocator<int>>;
+        for (int left_size : {2, 10}) {
+            for (int right_size : {3, 20}) {
+                Small left{TaggedAllocator<int>(1)};
+                Small right{TaggedAllocator<int>(2)};
+                Fill(left, left_size);
+                Fill(right, right_size, 1000);
+
+                left.Swap(right);
+                CHECK(left.Size() == static_cast<size_t>(right_size) && left[0] == 1000);
+                CHECK(right.Size() == static_cast<size_t>(left_size) && right[0] == 0);
+                CHECK(left.GetAllocator().id == 2 && right.GetAllocator().id == 1);
+
+                Small copy{TaggedAllocator<int>(3)};
+                Fill(copy, 30);
+                copy = left;
+                CHECK(copy.GetAllocator().id == 2 && copy.Size() == left.Size());
+
+                Small moved{TaggedAllocator<int>(4)};
+                Fill(moved, 30);
+                moved = std::move(right);
+                CHECK(moved.GetAllocator().id == 1 && moved.Size() == static_cast<size_t>(left_size));
+            }
+        }
+        CHECK(owners.empty());
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "vector.h"
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+template <typename T>
+T Make(int i) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        return std::string(20, static_cast<char>('a' + i));
+    }
+    else {
+        return static_cast<T>(i);
+    }
+}
+
+// Range inserts whose source is part of the vector itself, with and without
+// spare capacity, must insert the values the range held before the call.
+template <typename T>
+void CheckSelfInsert() {
+    for (size_t reserve : {0, 64}) {
+        for (size_t offset : {0, 2, 5}) {
+            for (size_t from : {0, 1, 3}) {
+                for (size_t count : {0, 1, 2}) {
+                    Vector<T> values;
+                    std::vector<T> expected;
+                    values.Reserve(reserve);
+                    for (int i = 0; i < 5; ++i) {
+                        values.PushBack(Make<T>(i));
+                        expected.push_back(Make<T>(i));
+                    }
+
+                    values.Insert(values.begin() + offset, values.begin() + from, values.begin() + from + count);
+                    std::vector<T> source(expected.begin() + from, expected.begin() + from + count);
+                    expected.insert(expected.begin() + offset, source.begin(), source.end());
+                    CHECK(values.Size() == expected.size());
+                    CHECK(std::equal(values.begin(), values.end(), expected.begin()));
+                }
+            }
+        }
+
+        Vector<T> values;
+        values.Reserve(reserve);
+        for (int i = 0; i < 5; ++i) {
+            values.PushBack(Make<T>(i));
+        }
+        values.AppendRange(values);
+        CHECK(values.Size() == 10 && values[5] == Make<T>(0) && values[9] == Make<T>(4));
+    }
+}
+
+}  // namespace
+
+int main() {
+    CheckSelfInsert<int>();
+    CheckSelfInsert<double>();
+    CheckSelfInsert<std::string>();
+    return 0;
+}
@@ -0,0 +1,25 @@
+#include "vector.h"
+
+#include <string>
+
+#include "check.h"
+
+// Built without VECTOR_STATS: reporting code must still compile and see nothing.
+int main() {
+    Vector<int> values;
+    {
+        VectorStatsScope scope("disabled");
+        for (int i = 0; i < 100; ++i) {
+            values.PushBack(i);
+        }
+    }
+
+    int tags = 0;
+    ForEachVectorStats([&tags](const std::string&, const VectorStatsSnapshot& stats) {
+        tags += static_cast<int>(stats.allocations) + 1;
+    });
+    CHECK(tags == 0);
+    ResetVectorStats();
+    PrintVectorStats(stderr);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "vector.h"
+
+#include <memory>
+#include <string>
+
+#include "check.h"
+#include "counting_new.h"
+
+namespace {
+
+// Its move may throw, so a middle insert goes through a second buffer.
+struct ThrowingMove {
+    explicit ThrowingMove(int i)
+        : value(std::to_string(i)) {
+    }
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&& other) noexcept(false)
+        : value(std::move(other.value)) {
+    }
+    ThrowingMove& operator=(const ThrowingMove&) = default;
+    ThrowingMove& operator=(ThrowingMove&&) = default;
+
+    std::string value;
+};
+
+// Same, but opted into relocation by bytes, which wins over the throwing move.
+struct RelocatableThrowingMove {
+    explicit RelocatableThrowingMove(int i)
+        : value(std::make_unique<int>(i)) {
+    }
+    RelocatableThrowingMove(RelocatableThrowingMove&& other) noexcept(false)
+        : value(std::move(other.value)) {
+    }
+
+    std::unique_ptr<int> value;
+};
+
+VectorStatsSnapshot Stats(const std::string& tag) {
+    VectorStatsSnapshot result;
+    ForEachVectorStats([&](const std::string& name, const VectorStatsSnapshot& stats) {
+        if (name == tag) {
+            result = stats;
+        }
+    });
+    return result;
+}
+
+}  // namespace
+
+template <>
+struct IsTriviallyRelocatable<RelocatableThrowingMove> : std::true_type {
+};
+
+int main() {
+    // The first events, outside any scope, must not allocate: the hooks are noexcept.
+    vector_stats::OnReallocate();
+    vector_stats::OnShift(3);
+    CHECK(HeapAllocations() == 0);
+    CHECK(Stats("untagged").reallocations == 1);
+    CHECK(Stats("untagged").elements_shifted == 3);
+
+    Vector<ThrowingMove> values;
+    values.Reserve(16);
+    for (int i = 0; i < 8; ++i) {
+        values.EmplaceBack(i);
+    }
+
+    {
+        VectorStatsScope scope("middle");
+        values.Emplace(values.begin() + 4, 100);
+    }
+    VectorStatsSnapshot middle = Stats("middle");
+    CHECK(middle.shifts == 1);
+    CHECK(middle.elements_shifted == 4);
+    CHECK(middle.reallocations == 0);
+    CHECK(values.Capacity() == 16 && values[4].value == "100" && values[5].value == "4");
+
+    {
+        VectorStatsScope scope("growth");
+        while (values.Size() < 17) {
+            values.EmplaceBack(0);
+        }
+    }
+    CHECK(Stats("growth").reallocations == 1);
+
+    Vector<RelocatableThrowingMove> relocatable;
+    relocatable.Reserve(16);
+    for (int i = 0; i < 8; ++i) {
+        relocatable.EmplaceBack(i);
+    }
+    {
+        VectorStatsScope scope("relocatable");
+        size_t before = HeapAllocations();
+        relocatable.Emplace(relocatable.begin() + 4, 100);
+        relocatable.Erase(relocatable.begin() + 1);
+        // Only the new element's own int.
+        CHECK(HeapAllocations() == before + 1);
+    }
+    VectorStatsSnapshot shifted = Stats("relocatable");
+    CHECK(shifted.shifts == 2 && shifted.allocations == 0 && shifted.elements_copied == 0);
+    CHECK(*relocatable[0].value == 0 && *relocatable[1].value == 2 && *relocatable[3].value == 100);
+    CHECK(*relocatable[4].value == 4 && relocatable.Size() == 8);
+    return 0;
+}